@@ -0,0 +1,206 @@
+#ifndef INCLUDE_SCHWEFEL_BATCH
+#define INCLUDE_SCHWEFEL_BATCH
+
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SCHWEFEL_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace Schwefel
+{
+
+// Batched evaluation of Schwefel's function. Candidates are stored as a structure of arrays: coordinate i of
+// candidate j is at x[i * stride + j], and every kernel evaluates all the candidates of a batch at once.
+//
+// Candidates do not interact, so a candidate gets the same value whichever batch and position it is evaluated in.
+// The scalar kernel computes exactly what soln::doEval() does. The AVX2 and AVX-512 kernels replace std::sin by
+// a range reduction to [-pi/2, pi/2] and a degree 11 polynomial, which is accurate to about 1e-7 in absolute
+// terms, so every term x_i * sin(sqrt|x_i|) is within |x_i| * 2e-7 of the scalar one and the objective values match
+// the scalar path within kernelTolerance * sum|x_i| (checked by SA_kernels).
+
+const float kernelTolerance = 1e-6;
+const int batchAlignment = 16; // strides are padded to a multiple of the widest vector, so kernels need no tail loop
+
+enum class evalKernel { scalar, avx2, avx512 };
+
+inline std::string kernelName(evalKernel kernel)
+{
+    switch(kernel)
+    {
+        case evalKernel::avx2: return "avx2";
+        case evalKernel::avx512: return "avx512";
+        default: return "scalar";
+    }
+}
+
+// evaluates the n candidates in x (padded to stride) into f, out of bound candidates get float max
+inline void evaluateScalar(const float* x, int stride, int n, int dim, float lbound, float ubound, float* f)
+{
+    for(int j=0; j<n; j++)
+    {
+        float tmp = 0;
+        for(int i=0; i<dim; i++)
+        {
+            float xi = x[i * stride + j];
+            if(xi < lbound | xi > ubound)
+            {
+                tmp = std::numeric_limits<float>::max(); // solution is outside constraints
+                break;
+            }
+            tmp -= xi * std::sin(std::sqrt(std::fabs(xi)));
+        }
+        f[j] = tmp;
+    }
+}
+
+#ifdef SCHWEFEL_X86_KERNELS
+__attribute__((target("avx2,fma")))
+inline __m256 sinAVX2(__m256 y)
+{   // sin(y): y = k * pi + r with r in [-pi/2, pi/2], sin(y) = (-1)^k sin(r)
+    __m256 k = _mm256_round_ps(_mm256_mul_ps(y, _mm256_set1_ps(0.318309886f)), _MM_FROUND_TO_NEAREST_INT|_MM_FROUND_NO_EXC);
+    __m256 r = _mm256_fnmadd_ps(k, _mm256_set1_ps(3.140625f), y); // pi split in three parts (Cody-Waite)
+    r = _mm256_fnmadd_ps(k, _mm256_set1_ps(9.67502593994140625e-4f), r);
+    r = _mm256_fnmadd_ps(k, _mm256_set1_ps(1.509957990978376432e-7f), r);
+    __m256 sign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtps_epi32(k), 31));
+    r = _mm256_xor_ps(r, sign);
+    __m256 r2 = _mm256_mul_ps(r, r);
+    __m256 p = _mm256_set1_ps(-2.5052108e-8f);
+    p = _mm256_fmadd_ps(p, r2, _mm256_set1_ps(2.7557319e-6f));
+    p = _mm256_fmadd_ps(p, r2, _mm256_set1_ps(-1.9841270e-4f));
+    p = _mm256_fmadd_ps(p, r2, _mm256_set1_ps(8.3333333e-3f));
+    p = _mm256_fmadd_ps(p, r2, _mm256_set1_ps(-1.6666667e-1f));
+    return _mm256_fmadd_ps(_mm256_mul_ps(p, r2), r, r);
+}
+
+__attribute__((target("avx2,fma")))
+inline void evaluateAVX2(const float* x, int stride, int n, int dim, float lbound, float ubound, float* f)
+{
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    const __m256 lb = _mm256_set1_ps(lbound);
+    const __m256 ub = _mm256_set1_ps(ubound);
+    for(int j=0; j<n; j+=8)
+    {
+        __m256 acc = _mm256_setzero_ps();
+        __m256 outside = _mm256_setzero_ps();
+        for(int i=0; i<dim; i++)
+        {
+            __m256 xi = _mm256_loadu_ps(x + i * stride + j);
+            outside = _mm256_or_ps(outside, _mm256_or_ps(_mm256_cmp_ps(xi, lb, _CMP_LT_OQ), _mm256_cmp_ps(xi, ub, _CMP_GT_OQ)));
+            __m256 s = sinAVX2(_mm256_sqrt_ps(_mm256_and_ps(xi, absMask)));
+            acc = _mm256_fnmadd_ps(xi, s, acc);
+        }
+        acc = _mm256_blendv_ps(acc, _mm256_set1_ps(std::numeric_limits<float>::max()), outside);
+        _mm256_storeu_ps(f + j, acc);
+    }
+}
+
+__attribute__((target("avx512f")))
+inline __m512 sinAVX512(__m512 y)
+{   // same as sinAVX2
+    __m512 k = _mm512_roundscale_ps(_mm512_mul_ps(y, _mm512_set1_ps(0.318309886f)), _MM_FROUND_TO_NEAREST_INT|_MM_FROUND_NO_EXC);
+    __m512 r = _mm512_fnmadd_ps(k, _mm512_set1_ps(3.140625f), y);
+    r = _mm512_fnmadd_ps(k, _mm512_set1_ps(9.67502593994140625e-4f), r);
+    r = _mm512_fnmadd_ps(k, _mm512_set1_ps(1.509957990978376432e-7f), r);
+    __m512i sign = _mm512_slli_epi32(_mm512_cvtps_epi32(k), 31);
+    r = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(r), sign));
+    __m512 r2 = _mm512_mul_ps(r, r);
+    __m512 p = _mm512_set1_ps(-2.5052108e-8f);
+    p = _mm512_fmadd_ps(p, r2, _mm512_set1_ps(2.7557319e-6f));
+    p = _mm512_fmadd_ps(p, r2, _mm512_set1_ps(-1.9841270e-4f));
+    p = _mm512_fmadd_ps(p, r2, _mm512_set1_ps(8.3333333e-3f));
+    p = _mm512_fmadd_ps(p, r2, _mm512_set1_ps(-1.6666667e-1f));
+    return _mm512_fmadd_ps(_mm512_mul_ps(p, r2), r, r);
+}
+
+__attribute__((target("avx512f")))
+inline void evaluateAVX512(const float* x, int stride, int n, int dim, float lbound, float ubound, float* f)
+{
+    const __m512 lb = _mm512_set1_ps(lbound);
+    const __m512 ub = _mm512_set1_ps(ubound);
+    for(int j=0; j<n; j+=16)
+    {
+        __m512 acc = _mm512_setzero_ps();
+        __mmask16 outside = 0;
+        for(int i=0; i<dim; i++)
+        {
+            __m512 xi = _mm512_loadu_ps(x + i * stride + j);
+            outside |= _mm512_cmp_ps_mask(xi, lb, _CMP_LT_OQ) | _mm512_cmp_ps_mask(xi, ub, _CMP_GT_OQ);
+            __m512 s = sinAVX512(_mm512_sqrt_ps(_mm512_abs_ps(xi)));
+            acc = _mm512_fnmadd_ps(xi, s, acc);
+        }
+        acc = _mm512_mask_blend_ps(outside, acc, _mm512_set1_ps(std::numeric_limits<float>::max()));
+        _mm512_storeu_ps(f + j, acc);
+    }
+}
+#endif // SCHWEFEL_X86_KERNELS
+
+inline bool kernelSupported(evalKernel kernel)
+{
+#ifdef SCHWEFEL_X86_KERNELS
+    if(kernel == evalKernel::avx2) return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    if(kernel == evalKernel::avx512) return __builtin_cpu_supports("avx512f");
+    return true;
+#else
+    return kernel == evalKernel::scalar;
+#endif
+}
+
+// the widest kernel the cpu running the program supports
+inline evalKernel bestKernel()
+{
+    static const evalKernel best = kernelSupported(evalKernel::avx512) ? evalKernel::avx512
+                                 : kernelSupported(evalKernel::avx2) ? evalKernel::avx2 : evalKernel::scalar;
+    return best;
+}
+
+// a batch of candidate solutions stored as a structure of arrays
+class solnBatch
+{
+private:
+    int _dim;
+    int _size;
+    int _stride;
+    std::vector<float> _x;
+    std::vector<float> _f;
+
+public:
+    solnBatch(int dim = 0, int capacity = 0) : _dim(dim), _size(0)
+    {
+        _stride = (capacity + batchAlignment - 1) / batchAlignment * batchAlignment;
+        _x.assign(_dim * _stride, 0);
+        _f.assign(_stride, 0);
+    }
+
+    int dimension(){ return _dim; }
+
+    int capacity(){ return _stride; }
+
+    int size(){ return _size; }
+
+    void resize(int size){ _size = size; }
+
+    float* coords(int i){ return _x.data() + i * _stride; } // coordinate i of every candidate
+
+    float getEval(int j){ return _f[j]; }
+
+    void evaluate(evalKernel kernel, float lbound, float ubound)
+    {
+        switch(kernel)
+        {
+#ifdef SCHWEFEL_X86_KERNELS
+            case evalKernel::avx2: evaluateAVX2(_x.data(), _stride, _size, _dim, lbound, ubound, _f.data()); break;
+            case evalKernel::avx512: evaluateAVX512(_x.data(), _stride, _size, _dim, lbound, ubound, _f.data()); break;
+#endif
+            default: evaluateScalar(_x.data(), _stride, _size, _dim, lbound, ubound, _f.data()); break;
+        }
+    }
+};
+
+} // namespace Schwefel
+
+#endif // INCLUDE_SCHWEFEL_BATCH
@@ -0,0 +1,60 @@
+import json
+import sys
+
+# compares the json output of SA_bench from two builds:
+#   python compare_bench.py baseline.json candidate.json [allowed slowdown, default 0.1]
+# and exits with 1 if a micro benchmark got slower by more than the allowed fraction, or if the soln<N> layout of the
+# candidate is slower than the layout of the hard-coded dimension build (its "reference" layout entries) by more
+# than the allowed fraction
+
+if len(sys.argv) < 3:
+    print("usage: compare_bench.py <baseline.json> <candidate.json> [allowed slowdown]")
+    sys.exit(0)
+
+with open(sys.argv[1]) as f:
+    baseline = json.load(f)
+with open(sys.argv[2]) as f:
+    candidate = json.load(f)
+allowed = float(sys.argv[3]) if len(sys.argv) > 3 else 0.1
+
+regressions = 0
+base_micro = {(b["name"], b["dimension"]): b for b in baseline["micro"]}
+for c in candidate["micro"]:
+    key = (c["name"], c["dimension"])
+    if key not in base_micro:
+        continue
+    ratio = c["ns per op"] / base_micro[key]["ns per op"]
+    flag = ""
+    if ratio > 1 + allowed:
+        flag = "  <-- slower"
+        regressions += 1
+    print("%-40s D=%-4d %10.2f ns -> %10.2f ns  x%.3f%s" % (c["name"], c["dimension"], base_micro[key]["ns per op"],
+                                                         c["ns per op"], ratio, flag))
+
+base_macro = {(b["dimension"], b["move coordinates"]): b for b in baseline["macro"]}
+for c in candidate["macro"]:
+    key = (c["dimension"], c["move coordinates"])
+    if key not in base_macro:
+        continue
+    b = base_macro[key]
+    print("D=%-4d move coordinates %-3d success rate %.2f -> %.2f, median time to target %.1f ms -> %.1f ms" %
+          (key[0], key[1], b["success rate"], c["success rate"], b["time to target ms"]["p50"],
+           c["time to target ms"]["p50"]))
+
+layouts = {b["name"]: b for b in candidate["micro"] if b["name"].startswith("layout ")}
+for operation in ["objective", "neighbour"]:
+    reference = layouts.get("layout %s reference" % operation)
+    if reference is None:
+        continue
+    for layout in ["soln<N>", "soln<0>"]:
+        c = layouts["layout %s %s" % (operation, layout)]
+        ratio = c["ns per op"] / reference["ns per op"]
+        flag = ""
+        if layout == "soln<N>" and ratio > 1 + allowed:
+            flag = "  <-- slower than the hard-coded layout"
+            regressions += 1
+        print("layout %-10s %-8s D=%-4d %10.2f ns vs %10.2f ns hard-coded  x%.3f%s" %
+              (operation, layout, c["dimension"], c["ns per op"], reference["ns per op"], ratio, flag))
+
+print(regressions, "micro benchmarks slower by more than", allowed * 100, "%")
+sys.exit(1 if regressions > 0 else 0)
@@ -1,5 +1,6 @@
 import subprocess
 import os
+import json
 import matplotlib.pyplot as plt
 import numpy as np
 
@@ -8,28 +9,30 @@ DIMENSIONS = 6
 # x_true = [420.966, 420.982]
 # f_true = -837.966
 # 6d optimal
-x_true = [420.973, 420.996, 420.967, 420.976, 420.95, 420.97] 
+x_true = [420.973, 420.996, 420.967, 420.976, 420.95, 420.97]
 f_true = -2513.9
 repeat = 10000
 l2_limit = 10
 
 
-failed_runs = 0
+def run_ensemble(program_path, parameter_path, output_path="ensemble.json"):
+    # all the runs are done inside a single SA_ensemble process, which writes the aggregated statistics to json
+    subprocess.run([program_path, parameter_path, str(repeat), output_path], cwd=os.getcwd(), check=True)
+    with open(output_path) as f:
+        res = json.load(f)
+    best = res["best f"]
+    edges = np.linspace(best["lower"], best["upper"], len(best["counts"]) + 1)
+    return res["success rate"], res["runtime ms"]["mean"], best["counts"], edges
 
-bins = np.linspace(-2600, -1400, 100)
-parameter_paths = [
-    ["SA", "Example/SchwefelFunction/parameters.json", "Release/SA_run"],
-    ["GA", "GAparameters.json", "./GA_run"],
-]
 
-for desc, parameter_path, program_path in parameter_paths:
-    f_curr_list = []
+def run_subprocess(program_path, parameter_path):
+    # for external programs that do one run per process (eg. the GA), scrape stdout of `repeat` launches
     f_best_list = []
     runtime_list = []
     numSuccess = 0
+    failed_runs = 0
     for i in range(repeat):
         print(str(i), "/", repeat, end='\r', flush=True)
-        # run the SA algor
         res = subprocess.run([program_path, parameter_path], cwd=os.getcwd(), stdout=subprocess.PIPE)
         s = str(res.stdout)
 
@@ -39,13 +42,6 @@ for desc, parameter_path, program_path in parameter_paths:
             end = s.find("ms", start)
             runtime_list.append(float(s[start:end]))
 
-            # # final solution
-            # start = s.find("current solution: x: [") + 22
-            # end = s.find("]", start)
-            # x = [float(xi) for xi in s[start:end].split(", ")]
-            # f = float(s[s.find("f: ", start)+3:s.find("best", start)-2])
-            # f_curr_list.append(f)
-
             # best solution found
             start = s.find("best solution: x: [") + 19
             end = s.find("]", start)
@@ -59,13 +55,26 @@ for desc, parameter_path, program_path in parameter_paths:
             if l2_norm**0.5 < l2_limit: numSuccess += 1
         except:
             failed_runs += 1
-        
+    print("failed number of runs: ", failed_runs)
+    counts, edges = np.histogram(f_best_list, np.linspace(-2600, -1400, 100))
+    return numSuccess/repeat, np.mean(runtime_list), counts, edges
+
+
+parameter_paths = [
+    ["SA", "Example/SchwefelFunction/parameters.json", "Release/SA_ensemble", run_ensemble],
+    ["GA", "GAparameters.json", "./GA_run", run_subprocess],
+]
+
+for desc, parameter_path, program_path, run in parameter_paths:
+    if not os.path.exists(program_path):
+        print("skipping", desc, ":", program_path, "not found")
+        continue
+    prob_success, mean_runtime, counts, edges = run(program_path, parameter_path)
     # print(x_true, f_true)
-    print("prob success:", numSuccess/repeat)
-    print("average runtime: ", np.mean(runtime_list), "ms")
-    plt.hist(f_best_list, bins, label=desc, alpha=0.5)
+    print("prob success:", prob_success)
+    print("average runtime: ", mean_runtime, "ms")
+    plt.stairs(counts, edges, label=desc, fill=True, alpha=0.5)
 
-print("failed number of runs: ", failed_runs)
 plt.xlabel("optimisation result")
 plt.ylabel(str("number of instances out of " + str(repeat) + " repeats"))
 plt.legend()
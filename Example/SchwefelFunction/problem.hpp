@@ -2,7 +2,10 @@
 #define INCLUDE_SCHWEFEL
 
 #include "../../lib/core.hpp"
+#include "../../lib/pool.hpp"
+#include "../../lib/estimate.hpp"
 #include <cstdlib>
+#include <functional>
 #include <ostream>
 #include <cmath>
 #include <vector>
@@ -12,49 +15,123 @@
 #include <utility>
 #include <limits>
 #include <sstream>
-
-#define DIMENSION 6 // to change this define for number of dimensions considered
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include "batch.hpp"
 
 namespace Schwefel
 {
-    static int num_of_evaluations = 0; // track the total number of evaluations of Schwefel's function
-    static std::mt19937 randomGen;
+// storage of the coordinates of a solution. When the dimension N is known at compile time it is an array, stored
+// on stack for faster creation/access/deletion and with loops the compiler can unroll. N = 0 is for dimensions only
+// known at runtime, the coordinates are then in a block from SA_blockPool so creating solutions does not allocate
+template <int N>
+struct coords
+{
+    float x[N];
+
+    coords(int dim = N) {}
+
+    int size() const { return N; }
+
+    float& operator[](int i){ return x[i]; }
+
+    const float& operator[](int i) const { return x[i]; }
+};
+
+template <>
+struct coords<0>
+{
+    float* x;
+    int dim;
+
+    coords(int d = 0) : x(d > 0 ? SA_blockPool::local().acquire(d) : nullptr), dim(d) {}
+
+    coords(const coords& other) : coords(other.dim) { std::copy(other.x, other.x + dim, x); }
+
+    coords(coords&& other) noexcept : x(other.x), dim(other.dim)
+    {
+        other.x = nullptr;
+        other.dim = 0;
+    }
+
+    coords& operator=(const coords& other)
+    {
+        if(this == &other) return *this;
+        if(dim != other.dim)
+        {
+            if(x != nullptr) SA_blockPool::local().release(x, dim);
+            dim = other.dim;
+            x = dim > 0 ? SA_blockPool::local().acquire(dim) : nullptr;
+        }
+        std::copy(other.x, other.x + dim, x);
+        return *this;
+    }
+
+    coords& operator=(coords&& other) noexcept
+    {
+        std::swap(x, other.x);
+        std::swap(dim, other.dim);
+        return *this;
+    }
 
+    ~coords(){ if(x != nullptr) SA_blockPool::local().release(x, dim); }
+
+    int size() const { return dim; }
+
+    float& operator[](int i){ return x[i]; }
+
+    const float& operator[](int i) const { return x[i]; }
+};
+
+// Schwefel's function is the sum of this term over every coordinate
+float objectiveTerm(float xi)
+{
+    return -xi * std::sin(std::sqrt(std::fabs(xi)));
+}
+
+template <int N>
 class soln
 {
 private:
-    float x[DIMENSION]; // using array instead of vector to have it stored on stack for faster creation/access/deletion
+    coords<N> x;
     float f;
     float _lbound;
     float _ubound;
 
     float evaluateObjective()
     {   // evaluate Schwefel's function on this solution
-        num_of_evaluations += 1;
         float tmp = 0;
-        for(int i=0; i<DIMENSION; i++) 
+        for(int i=0; i<x.size(); i++)
         {
             if(x[i] < _lbound | x[i] > _ubound) return std::numeric_limits<float>::max(); // solution is outside constraints
-            tmp -= x[i] * std::sin(std::sqrt(std::fabs(x[i])));
+            tmp += objectiveTerm(x[i]);
         }
         return tmp;
     }
 
 public:
-    soln(float lowerbound, float upperbound)
+    soln(int dim, float lowerbound, float upperbound, SA_random& randomGen) : x(dim)
     {  // randomly generate a soln within the provided constraints
         _lbound = lowerbound;
         _ubound = upperbound;
-        std::uniform_real_distribution<float> urand{lowerbound, upperbound};
-        for(int i=0; i<DIMENSION; i++) x[i] = urand(Schwefel::randomGen);
+        for(int i=0; i<x.size(); i++) x[i] = randomGen.uniform(lowerbound, upperbound);
         f = 0;
     }
 
-    soln()
+    soln(int dim, float lowerbound, float upperbound) : x(dim)
+    {   // all coordinates 0, within the provided constraints
+        _lbound = lowerbound;
+        _ubound = upperbound;
+        for(int i=0; i<x.size(); i++) x[i] = 0;
+        f = 0;
+    }
+
+    soln(int dim = N) : x(dim)
     {   // default constructor
         _lbound = 0;
         _ubound = 0;
-        for(int i=0; i<DIMENSION; i++) x[i] = 0;
+        for(int i=0; i<x.size(); i++) x[i] = 0;
         f = 0;
     }
 
@@ -62,13 +139,41 @@ public:
 
     float getEval(){ return f; }
 
+    void setEval(float val){ f = val; } // for solutions evaluated in a solnBatch
+
+    int size(){ return x.size(); }
+
     float getX(int i){ return x[i]; }
 
     void setX(int i, float val){ x[i]=val; }
 
+    void save(SA_snapshotWriter& writer)
+    {   // for snapshots: dimension, coordinates, objective value and bounds
+        writer.write(x.size());
+        writer.writeBytes(&x[0], x.size() * sizeof(float));
+        writer.write(f);
+        writer.write(_lbound);
+        writer.write(_ubound);
+    }
+
+    void load(SA_snapshotReader& reader)
+    {
+        int dim;
+        reader.read(dim);
+        if(dim != x.size())
+        {
+            if(N > 0) throw std::runtime_error("snapshot has a solution of dimension " + std::to_string(dim));
+            x = coords<N>(dim);
+        }
+        reader.readBytes(&x[0], dim * sizeof(float));
+        reader.read(f);
+        reader.read(_lbound);
+        reader.read(_ubound);
+    }
+
     friend std::ostream& operator<< (std::ostream& stream, const soln& s)
     {   // for printing out the contents of a solution
-        for(int i=0; i<DIMENSION; i++) stream << s.x[i] << ", ";
+        for(int i=0; i<s.x.size(); i++) stream << s.x[i] << ", ";
         stream << s.f;
         return stream;
     }
@@ -77,48 +182,260 @@ public:
     {   // same goal as operator<<, but slightly more formatted
         std::stringstream ss;
         ss << "x: [";
-        for(int i=0; i<DIMENSION-1; i++) ss << x[i] << ", ";
-        ss << x[DIMENSION-1] << "] f: " << f;
+        for(int i=0; i<x.size()-1; i++) ss << x[i] << ", ";
+        ss << x[x.size()-1] << "] f: " << f;
         return ss.str();
     }
 };
 
-void setRandomGen(std::mt19937& gen)
+// calls f with std::integral_constant<int, N>, where N is the dimension if soln<N> has a specialised fixed size
+// layout for it, or 0 (the runtime dimension layout) otherwise
+template <typename F>
+void withDimension(int dimension, F&& f)
+{
+    switch(dimension)
+    {
+        case 2: f(std::integral_constant<int, 2>{}); break;
+        case 4: f(std::integral_constant<int, 4>{}); break;
+        case 6: f(std::integral_constant<int, 6>{}); break;
+        case 8: f(std::integral_constant<int, 8>{}); break;
+        case 16: f(std::integral_constant<int, 16>{}); break;
+        case 32: f(std::integral_constant<int, 32>{}); break;
+        default: f(std::integral_constant<int, 0>{}); break;
+    }
+}
+
+struct params
+{   // typed copy of parameters.json, parsed once so the hot loop does not do any string lookups
+    int dimension;
+    int moveCoordinates; // coordinates changed by a move, 0 for all of them
+    float minXi;
+    float maxXi;
+    float initialMaxChange;
+    float alpha;
+    float w;
+    int maxSameTempChain;
+    int minAcceptedEachTemp;
+    int initialSearchSize;
+    int initialSearchThreads; // threads evaluating the initial search
+    bool warmStart; // start from the best solution of the initial search instead of a random one
+    bool temperatureCache; // reuse the initial temperature estimated by an earlier run, see SA_temperatureCache
+    bool scalarKernel; // evaluate batches with the scalar kernel, whatever the cpu supports
+    float temperatureScaling;
+    int maxTempSteps;
+    int restartThreshold;
+    int maxEval;
+};
+
+params parseParameters(std::unordered_map<std::string, float>& parameters)
+{
+    int dimension = parameters.count("dimension") ? static_cast<int>(parameters["dimension"]) : 6;
+    if(dimension < 1) throw std::runtime_error("the \"dimension\" must be at least 1");
+    return {
+        .dimension = dimension,
+        .moveCoordinates = parameters.count("move coordinates") ? static_cast<int>(parameters["move coordinates"]) : 0,
+        .minXi = parameters["min xi"],
+        .maxXi = parameters["max xi"],
+        .initialMaxChange = parameters["initial max change"],
+        .alpha = parameters["alpha"],
+        .w = parameters["w"],
+        .maxSameTempChain = static_cast<int>(parameters["max same temperature chain"]),
+        .minAcceptedEachTemp = static_cast<int>(parameters["min accepted at each temperature"]),
+        .initialSearchSize = static_cast<int>(parameters["initial search size"]),
+        .initialSearchThreads = parameters.count("initial search threads") ? static_cast<int>(parameters["initial search threads"]) : 1,
+        .warmStart = parameters.count("warm start") ? parameters["warm start"] != 0 : false,
+        .temperatureCache = parameters.count("temperature cache") ? parameters["temperature cache"] != 0 : false,
+        .scalarKernel = parameters.count("scalar kernel") ? parameters["scalar kernel"] != 0 : false,
+        .temperatureScaling = parameters["temperature scaling"],
+        .maxTempSteps = static_cast<int>(parameters["max temperature steps"]),
+        .restartThreshold = static_cast<int>(parameters["restart threshold"]),
+        .maxEval = static_cast<int>(parameters["max eval"])
+    };
+}
+
+const int batchCapacity = 256; // number of candidates evaluated together
+const int initialSearchChunk = 4 * batchCapacity; // solutions of the initial search drawn from the same stream
+const int searchRoundChunks = 16; // chunks of the initial search each thread does between two checks for a stop
+
+template <int N>
+struct context
+{   // per-run state: each run has its own random generator and evaluation counter so that runs
+    // can be done concurrently
+    params parameters;
+    SA_random randomGen; // split from the stream of the engine
+    long num_of_evaluations = 0; // track the cost of the search, in evaluations of a single coordinate's term. Whole
+                                 // solutions are counted when the chain tests them (see acceptProbability)
+    long num_of_initial_evaluations = 0; // spent on the initial search, not counted in the "max eval" budget
+    bool temperatureEstimated = false; // the initial search is done once per context
+    float initialTemperature = 0;
+    bool hasBestSample = false;
+    soln<N> bestSample; // best solution of the initial search, for warm starts
+    int numDeltaUpdates = 0; // moves applied to the curr soln since its objective was last computed in full
+    solnBatch batch; // reused for every batch evaluation of the run
+    evalKernel kernel = bestKernel(); // the objective values of batches, and so the chain, depend on it
+    // checked between rounds of the initial search, if it returns false the search stops with the solutions
+    // sampled so far and the run ends before its first step (a cancelled job or one out of time, see SA_server)
+    std::function<bool()> continueSearch;
+    bool searchStopped = false;
+};
+
+template <int N>
+context<N> createContext(std::unordered_map<std::string, float>& parameters)
+{   // with a fixed size layout the dimension is N, whatever the parameters say
+    context<N> ctx{ .parameters = parseParameters(parameters) };
+    if constexpr (N > 0) ctx.parameters.dimension = N;
+    if(ctx.parameters.scalarKernel) ctx.kernel = evalKernel::scalar;
+    ctx.batch = solnBatch{ctx.parameters.dimension, batchCapacity};
+    return ctx;
+}
+
+template <int N>
+void setRandomGen(context<N>& ctx, SA_random& gen)
 {
-    randomGen = gen;
+    ctx.randomGen = gen;
+}
+
+template <int N>
+void saveState(context<N>& ctx, SA_snapshotWriter& writer)
+{   // the per-run state, everything else in the context comes from the parameters
+    writer.write(ctx.randomGen);
+    writer.write(ctx.num_of_evaluations);
+    writer.write(ctx.num_of_initial_evaluations);
+    writer.write(ctx.numDeltaUpdates);
 }
 
-float l2(soln& s1, soln& s2)
+template <int N>
+void loadState(context<N>& ctx, SA_snapshotReader& reader)
+{
+    reader.read(ctx.randomGen);
+    reader.read(ctx.num_of_evaluations);
+    reader.read(ctx.num_of_initial_evaluations);
+    reader.read(ctx.numDeltaUpdates);
+}
+
+template <int N>
+void shareBudget(context<N>& ctx, int numParts)
+{   // each of numParts runs gets its share of "max eval", rounded up like SA_tempering does "max iterations"
+    ctx.parameters.maxEval = (ctx.parameters.maxEval + numParts - 1) / numParts;
+}
+
+template <int N>
+float l2(soln<N>& s1, soln<N>& s2)
 {  // get the l2 norm of s1-s2
-    float sum = 0; 
-    for(int i=0; i<DIMENSION; i++) sum += std::pow(s1.getX(i) - s2.getX(i), 2);
+    float sum = 0;
+    for(int i=0; i<s1.size(); i++) sum += std::pow(s1.getX(i) - s2.getX(i), 2);
     return std::pow(sum, 0.5);
 }
 
-float findStdDev(std::unordered_map<std::string, float>& parameters)
-{   // perform initial search to get the standard deviation of the object function in search space
-    float e_f = 0;  // to find E[f]
-    float e_f2 = 0; // to find E[f^2]
-    for(int i=0; i<parameters["initial search size"]; i++)
+const float optimumXi = 420.9687; // the known global minimum of Schwefel's function has x_i = optimumXi for every i
+
+template <int N>
+soln<N> globalOptimum(int dimension)
+{   // the known global minimum of Schwefel's function
+    soln<N> s{dimension};
+    for(int i=0; i<s.size(); i++) s.setX(i, optimumXi);
+    return s;
+}
+
+template <int N>
+void sampleChunk(context<N>& ctx, SA_random& gen, solnBatch& batch, int size, SA_welford& stats, soln<N>& best)
+{   // evaluates size random solutions drawn from gen, batchCapacity at a time
+    for(int start=0; start<size; start+=batch.capacity())
     {
-        soln s{parameters["min xi"], parameters["max xi"]};
-        s.doEval();
-        e_f += s.getEval();
-        e_f2 += (s.getEval() * s.getEval());
+        batch.resize(std::min(batch.capacity(), size - start));
+        for(int i=0; i<ctx.parameters.dimension; i++)
+            gen.fillUniform(batch.coords(i), batch.size(), ctx.parameters.minXi, ctx.parameters.maxXi);
+        batch.evaluate(ctx.kernel, ctx.parameters.minXi, ctx.parameters.maxXi);
+        for(int j=0; j<batch.size(); j++)
+        {
+            stats.add(batch.getEval(j));
+            if(batch.getEval(j) < best.getEval())
+            {
+                for(int i=0; i<best.size(); i++) best.setX(i, batch.coords(i)[j]);
+                best.setEval(batch.getEval(j));
+            }
+        }
     }
-    e_f /= parameters["initial search size"]; // E[f]
-    e_f2 /= parameters["initial search size"]; // E[f^2]
-    float variance = e_f2 - e_f * e_f; // variance = E[f^2] - E[f]^2
-    return std::pow(variance, 0.5); // to get standard deviation
 }
 
-SA_policy<soln> initialiseRuntimeInfo(std::unordered_map<std::string, float>& parameters)
+template <int N>
+SA_welford sampleObjective(context<N>& ctx, soln<N>& best)
+{   // evaluate "initial search size" random solutions, in chunks of initialSearchChunk with a stream each split from
+    // the one of the context, so the sample does not depend on the number of threads. The chunks are done in rounds
+    // of searchRoundChunks per thread, spread over "initial search threads" threads, and their statistics merged in
+    // order. continueSearch is checked before each round, the rounds left when it returns false are not sampled
+    int size = ctx.parameters.initialSearchSize;
+    int numChunks = (size + initialSearchChunk - 1) / initialSearchChunk;
+    int numThreads = std::max(1, std::min(ctx.parameters.initialSearchThreads, numChunks));
+    int roundChunks = numThreads * searchRoundChunks;
+    std::vector<solnBatch> batches(numThreads - 1, solnBatch{ctx.parameters.dimension, batchCapacity});
+    std::vector<SA_random> gens(roundChunks);
+    std::vector<SA_welford> stats(roundChunks);
+    std::vector<soln<N>> bests(roundChunks, soln<N>{ctx.parameters.dimension, ctx.parameters.minXi, ctx.parameters.maxXi});
+    SA_welford total;
+    for(int first=0; first<numChunks; first+=roundChunks)
+    {
+        if(ctx.continueSearch && !ctx.continueSearch())
+        {
+            ctx.searchStopped = true;
+            break;
+        }
+        int n = std::min(roundChunks, numChunks - first);
+        for(int c=0; c<n; c++)
+        {
+            gens[c] = ctx.randomGen.split();
+            stats[c] = SA_welford{};
+            bests[c].setEval(std::numeric_limits<float>::max());
+        }
+        auto runChunks = [&](int offset, solnBatch& batch)
+        {
+            for(int c=offset; c<n; c+=numThreads)
+            {
+                int chunkSize = std::min(initialSearchChunk, size - (first + c) * initialSearchChunk);
+                sampleChunk(ctx, gens[c], batch, chunkSize, stats[c], bests[c]);
+            }
+        };
+        std::vector<std::thread> threads;
+        for(int t=1; t<std::min(numThreads, n); t++) threads.emplace_back(runChunks, t, std::ref(batches[t - 1]));
+        runChunks(0, ctx.batch);
+        for(std::thread& t : threads) t.join();
+        for(int c=0; c<n; c++)
+        {
+            total.merge(stats[c]);
+            if(bests[c].getEval() < best.getEval()) best = bests[c];
+        }
+    }
+    ctx.num_of_initial_evaluations += total.count * ctx.parameters.dimension;
+    return total;
+}
+
+template <int N>
+void estimateTemperature(context<N>& ctx)
+{   // the initial temperature is the standard deviation of the objective over random solutions. It is looked up in
+    // the temperature cache first if "temperature cache" is set, there is no warm start solution then
+    if(ctx.temperatureEstimated) return;
+    ctx.temperatureEstimated = true;
+    std::ostringstream key;
+    key << "schwefel " << ctx.parameters.dimension << ' ' << ctx.parameters.minXi << ' ' << ctx.parameters.maxXi
+        << ' ' << ctx.parameters.initialSearchSize << ' ' << ctx.parameters.initialMaxChange;
+    SA_temperatureCache cache;
+    if(ctx.parameters.temperatureCache && cache.find(key.str(), ctx.initialTemperature)) return;
+    soln<N> best{ctx.parameters.dimension, ctx.parameters.minXi, ctx.parameters.maxXi};
+    best.setEval(std::numeric_limits<float>::max());
+    ctx.initialTemperature = sampleObjective(ctx, best).stdDev();
+    ctx.bestSample = best;
+    ctx.hasBestSample = best.getEval() < std::numeric_limits<float>::max();
+    if(ctx.parameters.temperatureCache && !ctx.searchStopped) cache.store(key.str(), ctx.initialTemperature);
+}
+
+template <int N>
+SA_policy<soln<N>> initialiseRuntimeInfo(context<N>& ctx)
 {   // initialise the runtime parameters with starting values
-    soln initialMaxChange{};
-    for(int i=0; i<DIMENSION; i++) initialMaxChange.setX(i, parameters["initial max change"]);
-    float initialtemperature = findStdDev(parameters);
+    soln<N> initialMaxChange{ctx.parameters.dimension};
+    for(int i=0; i<initialMaxChange.size(); i++) initialMaxChange.setX(i, ctx.parameters.initialMaxChange);
+    estimateTemperature(ctx);
     return {
-        .temperature = initialtemperature,
+        .temperature = ctx.initialTemperature,
         .maxChange = initialMaxChange,
         .numAcceptedCurrTemp = 0,
         .numCurrTemp = 0,
@@ -127,48 +444,104 @@ SA_policy<soln> initialiseRuntimeInfo(std::unordered_map<std::string, float>& pa
     };
 }
 
-soln getRandomSolution(std::unordered_map<std::string, float>& parameters)
-{   // return a random solution within problem constraints
-    soln s{parameters["min xi"], parameters["max xi"]};
+template <int N>
+soln<N> getRandomSolution(context<N>& ctx)
+{   // return a random solution within problem constraints, or the best one of the initial search with "warm start"
+    if(ctx.parameters.warmStart)
+    {
+        estimateTemperature(ctx);
+        if(ctx.hasBestSample) return ctx.bestSample;
+    }
+    soln<N> s{ctx.parameters.dimension, ctx.parameters.minXi, ctx.parameters.maxXi, ctx.randomGen};
     s.doEval();
+    ctx.num_of_evaluations += s.size();
     return s;
 }
 
-soln getNewSolution(std::unordered_map<std::string, float>& parameters,
-                    SA_policy<soln>& runtimeInfo, soln& currSoln)
+template <int N>
+float newCoordinate(context<N>& ctx, SA_policy<soln<N>>& runtimeInfo, soln<N>& currSoln, int i)
+{   // x_i + u * maxChange_i with u uniform in [-1, 1] conditioned on the result being within the bounds is uniform
+    // on the intersection of [x_i - maxChange_i, x_i + maxChange_i] and the bounds, so a single draw is enough
+    float lower = std::max(ctx.parameters.minXi, currSoln.getX(i) - runtimeInfo.maxChange.getX(i));
+    float upper = std::min(ctx.parameters.maxXi, currSoln.getX(i) + runtimeInfo.maxChange.getX(i));
+    return std::min(upper, ctx.randomGen.uniform(lower, upper)); // rounding could step just past upper
+}
+
+template <int N>
+soln<N> getNewSolution(context<N>& ctx,
+                       SA_policy<soln<N>>& runtimeInfo, soln<N>& currSoln)
 {   // generate a new solution from the current solution using:
     // x_new = x_curr + D * u
     // where D is a diagonal matrix of max change in each dimension
-    // and u is a vector of random values in [-1, 1]
-    soln s{parameters["min xi"], parameters["max xi"]};
-    std::uniform_real_distribution<float> urand{-1.0, 1.0};
-    for(int i=0; i<DIMENSION; i++)
-    {
-        float newxi = parameters["max xi"] + 1;
-        while((newxi > parameters["max xi"]) | (newxi < parameters["min xi"]))
-            newxi = currSoln.getX(i) + urand(randomGen) * runtimeInfo.maxChange.getX(i);
-        s.setX(i, newxi);
-    }
+    // and u is a vector of random values in [-1, 1], conditioned on x_new being within the bounds
+    soln<N> s = currSoln;
+    for(int i=0; i<s.size(); i++) s.setX(i, newCoordinate(ctx, runtimeInfo, currSoln, i));
     s.doEval();
     return s;
 }
 
-float acceptProbability(std::unordered_map<std::string, float>& parameters, 
-                        SA_policy<soln>& runtimeInfo, soln& newSoln, soln& currSoln)
+template <int N>
+void proposeSolution(context<N>& ctx, SA_policy<soln<N>>& runtimeInfo, soln<N>& currSoln, soln<N>& newSoln)
+{   // getNewSolution without the evaluation, which is done by evaluate (on another thread with speculative steps)
+    newSoln = currSoln;
+    for(int i=0; i<newSoln.size(); i++) newSoln.setX(i, newCoordinate(ctx, runtimeInfo, currSoln, i));
+}
+
+template <int N>
+void evaluate(context<N>& ctx, std::vector<soln<N>>& solns, int first, int last)
+{   // evaluates solns[first, last) with the kernel of getNewSolutions, so they get the same objective values as
+    // there. Only reads the context, so ranges can be evaluated concurrently: every thread has a batch of its own
+    static thread_local solnBatch batch;
+    if(batch.dimension() != ctx.parameters.dimension) batch = solnBatch{ctx.parameters.dimension, batchCapacity};
+    for(int start=first; start<last; start+=batch.capacity())
+    {
+        batch.resize(std::min(batch.capacity(), last - start));
+        for(int j=0; j<batch.size(); j++)
+            for(int i=0; i<ctx.parameters.dimension; i++) batch.coords(i)[j] = solns[start + j].getX(i);
+        batch.evaluate(ctx.kernel, ctx.parameters.minXi, ctx.parameters.maxXi);
+        for(int j=0; j<batch.size(); j++) solns[start + j].setEval(batch.getEval(j));
+    }
+}
+
+template <int N>
+void getNewSolutions(context<N>& ctx, SA_policy<soln<N>>& runtimeInfo, soln<N>& currSoln, std::vector<soln<N>>& newSolns)
+{   // same as getNewSolution for every element of newSolns, but the new solutions are evaluated together
+    // in batches
+    solnBatch& batch = ctx.batch;
+    for(int start=0; start<newSolns.size(); start+=batch.capacity())
+    {
+        batch.resize(std::min<int>(batch.capacity(), newSolns.size() - start));
+        for(int j=0; j<batch.size(); j++)
+        {
+            soln<N>& s = newSolns[start + j];
+            s = currSoln;
+            for(int i=0; i<s.size(); i++)
+            {
+                float newxi = newCoordinate(ctx, runtimeInfo, currSoln, i);
+                s.setX(i, newxi);
+                batch.coords(i)[j] = newxi;
+            }
+        }
+        batch.evaluate(ctx.kernel, ctx.parameters.minXi, ctx.parameters.maxXi);
+        for(int j=0; j<batch.size(); j++) newSolns[start + j].setEval(batch.getEval(j));
+    }
+}
+
+template <int N>
+float acceptProbability(context<N>& ctx,
+                        SA_policy<soln<N>>& runtimeInfo, soln<N>& newSoln, soln<N>& currSoln)
 {   // get the acceptance probability of newsoln given curr soln
-    // better solutions are always accepted
+    // better solutions are always accepted. The evaluation of newSoln is counted here, when the chain tests it, so
+    // the proposals of a step left untested after an acceptance do not count against "max eval"
+    ctx.num_of_evaluations += newSoln.size();
     return std::exp(-(newSoln.getEval() - currSoln.getEval())/(runtimeInfo.temperature * l2(newSoln, currSoln)));
 }
 
-void updateRuntimeInfo(std::unordered_map<std::string, float>& parameters, 
-                       SA_policy<soln>& runtimeInfo, soln& newSoln, soln& currSoln, bool accepted)
+template <int N>
+void advanceSchedule(context<N>& ctx, SA_policy<soln<N>>& runtimeInfo, bool accepted)
 {
     if(accepted)
-    {   // new solution is accepted, so we update the max change values
-        for(int i=0; i<DIMENSION; i++) runtimeInfo.maxChange.setX(i, 
-            runtimeInfo.maxChange.getX(i) * (1-parameters["alpha"]) +
-            parameters["alpha"] * parameters["w"] * std::abs(newSoln.getX(i) - currSoln.getX(i))
-        );
+    {
         runtimeInfo.numAcceptedCurrTemp += 1;
         runtimeInfo.numCurrTemp += 1;
         runtimeInfo.numNoProgress = 0;
@@ -177,26 +550,144 @@ void updateRuntimeInfo(std::unordered_map<std::string, float>& parameters,
         runtimeInfo.numCurrTemp += 1;
         runtimeInfo.numNoProgress += 1;
     }
-    if((runtimeInfo.numAcceptedCurrTemp > parameters["min accepted at each temperature"]) |
-       (runtimeInfo.numCurrTemp > parameters["max same temperature chain"]))
+    if((runtimeInfo.numAcceptedCurrTemp > ctx.parameters.minAcceptedEachTemp) |
+       (runtimeInfo.numCurrTemp > ctx.parameters.maxSameTempChain))
     {   // desired length of markov chain at current temperature is reached, so we move forward
         // the annealing schedule and update the temperature
-        runtimeInfo.temperature *= parameters["temperature scaling"];
+        runtimeInfo.temperature *= ctx.parameters.temperatureScaling;
         runtimeInfo.numTempSteps += 1;
         runtimeInfo.numAcceptedCurrTemp = 0;
         runtimeInfo.numCurrTemp = 0;
     }
 }
 
-bool compareSoln(soln& betterSoln, soln& worseSoln)
+template <int N>
+void updateRuntimeInfo(context<N>& ctx,
+                       SA_policy<soln<N>>& runtimeInfo, soln<N>& newSoln, soln<N>& currSoln, bool accepted)
+{
+    if(accepted)
+    {   // new solution is accepted, so we update the max change values
+        for(int i=0; i<newSoln.size(); i++) runtimeInfo.maxChange.setX(i,
+            runtimeInfo.maxChange.getX(i) * (1-ctx.parameters.alpha) +
+            ctx.parameters.alpha * ctx.parameters.w * std::abs(newSoln.getX(i) - currSoln.getX(i))
+        );
+    }
+    advanceSchedule(ctx, runtimeInfo, accepted);
+}
+
+template <int N>
+struct coordMove
+{   // a change of some of the coordinates of a solution: x[index[c]] becomes newX[c] for c < numChanged
+    int numChanged = 0;
+    std::vector<int> index; // a permutation of the coordinates, the changed ones first
+    std::vector<int> swappedWith; // index[c] was swapped with index[swappedWith[c]] to pick it
+    std::vector<float> newX;
+    float newEval = 0; // objective value after the move, filled in by deltaEvaluate
+};
+
+template <int N>
+void getNewMove(context<N>& ctx, SA_policy<soln<N>>& runtimeInfo, soln<N>& currSoln, coordMove<N>& move)
+{   // same as getNewSolution, but only "move coordinates" randomly picked coordinates are changed
+    int dim = currSoln.size();
+    if(move.index.size() != dim)
+    {
+        move.index.resize(dim);
+        for(int i=0; i<dim; i++) move.index[i] = i;
+        move.newX.resize(dim);
+        move.swappedWith.resize(dim);
+        move.numChanged = 0;
+    }
+    // undo the shuffle of the last move, so which coordinates are picked only depends on the random stream
+    // (and a run resumed from a snapshot picks the same ones)
+    for(int c=move.numChanged-1; c>=0; c--) std::swap(move.index[c], move.index[move.swappedWith[c]]);
+    int k = ctx.parameters.moveCoordinates;
+    move.numChanged = (k <= 0 || k >= dim) ? dim : k;
+    for(int c=0; c<move.numChanged; c++)
+    {
+        // partial Fisher-Yates shuffle, picks numChanged distinct coordinates
+        move.swappedWith[c] = move.numChanged < dim ? ctx.randomGen.uniformInt(c, dim - 1) : c;
+        std::swap(move.index[c], move.index[move.swappedWith[c]]);
+        move.newX[c] = newCoordinate(ctx, runtimeInfo, currSoln, move.index[c]);
+    }
+}
+
+template <int N>
+void deltaEvaluate(context<N>& ctx, coordMove<N>& move, soln<N>& currSoln)
+{   // Schwefel's function is separable, so only the terms of the changed coordinates are computed. That is 2
+    // coordinate evaluations (old and new term) per changed coordinate, or 1 per coordinate if they all change
+    if(move.numChanged == currSoln.size())
+    {
+        float tmp = 0;
+        for(int c=0; c<move.numChanged; c++) tmp += objectiveTerm(move.newX[c]);
+        move.newEval = tmp;
+        ctx.num_of_evaluations += move.numChanged;
+        return;
+    }
+    float delta = 0;
+    for(int c=0; c<move.numChanged; c++)
+        delta += objectiveTerm(move.newX[c]) - objectiveTerm(currSoln.getX(move.index[c]));
+    move.newEval = currSoln.getEval() + delta;
+    ctx.num_of_evaluations += 2 * move.numChanged;
+}
+
+template <int N>
+void apply(context<N>& ctx, coordMove<N>& move, soln<N>& currSoln)
+{
+    for(int c=0; c<move.numChanged; c++) currSoln.setX(move.index[c], move.newX[c]);
+    currSoln.setEval(move.newEval);
+    if(move.numChanged < currSoln.size() && ++ctx.numDeltaUpdates >= currSoln.size())
+    {   // rounding errors add up over the delta updates, so the objective is recomputed in full every
+        // dimension updates (on average one more coordinate evaluation per update)
+        currSoln.doEval();
+        ctx.num_of_evaluations += currSoln.size();
+        ctx.numDeltaUpdates = 0;
+    }
+}
+
+template <int N>
+float acceptProbability(context<N>& ctx,
+                        SA_policy<soln<N>>& runtimeInfo, coordMove<N>& move, soln<N>& currSoln)
+{   // same as for a new solution, only the changed coordinates add to the l2 norm
+    float sum = 0;
+    for(int c=0; c<move.numChanged; c++) sum += std::pow(move.newX[c] - currSoln.getX(move.index[c]), 2);
+    return std::exp(-(move.newEval - currSoln.getEval())/(runtimeInfo.temperature * std::pow(sum, 0.5)));
+}
+
+template <int N>
+void updateRuntimeInfo(context<N>& ctx,
+                       SA_policy<soln<N>>& runtimeInfo, coordMove<N>& move, soln<N>& currSoln, bool accepted)
+{
+    if(accepted)
+    {   // only the max change of the changed coordinates is updated
+        for(int c=0; c<move.numChanged; c++)
+        {
+            int i = move.index[c];
+            runtimeInfo.maxChange.setX(i,
+                runtimeInfo.maxChange.getX(i) * (1-ctx.parameters.alpha) +
+                ctx.parameters.alpha * ctx.parameters.w * std::abs(move.newX[c] - currSoln.getX(i))
+            );
+        }
+    }
+    advanceSchedule(ctx, runtimeInfo, accepted);
+}
+
+template <int N>
+bool compareSoln(soln<N>& betterSoln, soln<N>& worseSoln)
 {   // compare if the betterSoln is really more optimal than the worseSoln
     return betterSoln.getEval() < worseSoln.getEval();
 }
 
-bool endSearch(std::unordered_map<std::string, float>& parameters, SA_policy<soln>& runtimeInfo)
-{   // end the algorithm if any conditions are met
-    if((Schwefel::num_of_evaluations > parameters["max eval"]) |
-       (runtimeInfo.numTempSteps > parameters["max temperature steps"]))
+template <int N>
+float getEnergy(soln<N>& s)
+{   // the objective value is used as the energy when exchanging solutions between chains
+    return s.getEval();
+}
+
+template <int N>
+bool endSearch(context<N>& ctx, SA_policy<soln<N>>& runtimeInfo)
+{   // end the algorithm if any conditions are met, "max eval" is in evaluations of a whole solution
+    if((ctx.num_of_evaluations > static_cast<long>(ctx.parameters.maxEval) * ctx.parameters.dimension) |
+       (runtimeInfo.numTempSteps > ctx.parameters.maxTempSteps) | ctx.searchStopped)
     {
         return true;
     }else
@@ -205,22 +696,100 @@ bool endSearch(std::unordered_map<std::string, float>& parameters, SA_policy<sol
     }
 }
 
-bool restartSearch(std::unordered_map<std::string, float>& parameters, SA_policy<soln>& runtimeInfo)
+template <int N>
+bool restartSearch(context<N>& ctx, SA_policy<soln<N>>& runtimeInfo)
 {   // restarts if there has been no progress for more iterations than threshold
-    return runtimeInfo.numNoProgress > parameters["restart threshold"];
+    return runtimeInfo.numNoProgress > ctx.parameters.restartThreshold;
 }
 
 // store the problem specific methods for the SA core to run on
-static ProblemCtx<soln> problemCtx = {
-    .setRandomGenerator = &setRandomGen,
-    .initRuntimeInfo = &initialiseRuntimeInfo,
-    .getRandomSolution = &getRandomSolution,
-    .getNewSolution = &getNewSolution,
-    .acceptProbability = &acceptProbability,
-    .updateRuntimeInfo = &updateRuntimeInfo,
-    .compareSoln = &compareSoln,
-    .endSearch = &endSearch,
-    .restart = &restartSearch
+template <int N>
+ProblemCtx<soln<N>, context<N>> problemCtx = {
+    .createContext = &createContext<N>,
+    .setRandomGenerator = &setRandomGen<N>,
+    .initRuntimeInfo = &initialiseRuntimeInfo<N>,
+    .getRandomSolution = &getRandomSolution<N>,
+    .getNewSolution = &getNewSolution<N>,
+    .acceptProbability = &acceptProbability<N>,
+    .updateRuntimeInfo = &updateRuntimeInfo<N>,
+    .compareSoln = &compareSoln<N>,
+    .getEnergy = &getEnergy<N>,
+    .endSearch = &endSearch<N>,
+    .restart = &restartSearch<N>,
+    .saveState = &saveState<N>,
+    .loadState = &loadState<N>,
+    .shareBudget = &shareBudget<N>
+};
+
+// the same problem specific methods as a problem policy for SA_engine, which lets them be inlined
+template <int N>
+struct Problem
+{
+    using soln_type = soln<N>;
+    using context_type = context<N>;
+    using move_type = coordMove<N>;
+
+    static context<N> createContext(std::unordered_map<std::string, float>& parameters)
+    {
+        return Schwefel::createContext<N>(parameters);
+    }
+    static void setRandomGenerator(context<N>& ctx, SA_random& gen){ setRandomGen(ctx, gen); }
+    static SA_policy<soln<N>> initRuntimeInfo(context<N>& ctx){ return initialiseRuntimeInfo(ctx); }
+    static soln<N> getRandomSolution(context<N>& ctx){ return Schwefel::getRandomSolution(ctx); }
+    static soln<N> getNewSolution(context<N>& ctx, SA_policy<soln<N>>& runtimeInfo, soln<N>& currSoln)
+    {
+        return Schwefel::getNewSolution(ctx, runtimeInfo, currSoln);
+    }
+    static void getNewSolutions(context<N>& ctx, SA_policy<soln<N>>& runtimeInfo, soln<N>& currSoln,
+                                std::vector<soln<N>>& newSolns)
+    {
+        Schwefel::getNewSolutions(ctx, runtimeInfo, currSoln, newSolns);
+    }
+    static void proposeSolution(context<N>& ctx, SA_policy<soln<N>>& runtimeInfo, soln<N>& currSoln, soln<N>& newSoln)
+    {
+        Schwefel::proposeSolution(ctx, runtimeInfo, currSoln, newSoln);
+    }
+    static void evaluate(context<N>& ctx, std::vector<soln<N>>& solns, int first, int last)
+    {
+        Schwefel::evaluate(ctx, solns, first, last);
+    }
+    static void getNewMove(context<N>& ctx, SA_policy<soln<N>>& runtimeInfo, soln<N>& currSoln, coordMove<N>& move)
+    {
+        Schwefel::getNewMove(ctx, runtimeInfo, currSoln, move);
+    }
+    static void deltaEvaluate(context<N>& ctx, coordMove<N>& move, soln<N>& currSoln)
+    {
+        Schwefel::deltaEvaluate(ctx, move, currSoln);
+    }
+    static void apply(context<N>& ctx, coordMove<N>& move, soln<N>& currSoln){ Schwefel::apply(ctx, move, currSoln); }
+    static float acceptProbability(context<N>& ctx, SA_policy<soln<N>>& runtimeInfo, soln<N>& newSoln, soln<N>& currSoln)
+    {
+        return Schwefel::acceptProbability(ctx, runtimeInfo, newSoln, currSoln);
+    }
+    static float acceptProbability(context<N>& ctx, SA_policy<soln<N>>& runtimeInfo, coordMove<N>& move, soln<N>& currSoln)
+    {
+        return Schwefel::acceptProbability(ctx, runtimeInfo, move, currSoln);
+    }
+    static void updateRuntimeInfo(context<N>& ctx, SA_policy<soln<N>>& runtimeInfo,
+                                  soln<N>& newSoln, soln<N>& currSoln, bool accepted)
+    {
+        Schwefel::updateRuntimeInfo(ctx, runtimeInfo, newSoln, currSoln, accepted);
+    }
+    static void updateRuntimeInfo(context<N>& ctx, SA_policy<soln<N>>& runtimeInfo,
+                                  coordMove<N>& move, soln<N>& currSoln, bool accepted)
+    {
+        Schwefel::updateRuntimeInfo(ctx, runtimeInfo, move, currSoln, accepted);
+    }
+    static bool compareSoln(context<N>& ctx, soln<N>& betterSoln, soln<N>& worseSoln)
+    {
+        return Schwefel::compareSoln(betterSoln, worseSoln);
+    }
+    static float getEnergy(context<N>& ctx, soln<N>& s){ return Schwefel::getEnergy(s); }
+    static bool endSearch(context<N>& ctx, SA_policy<soln<N>>& runtimeInfo){ return Schwefel::endSearch(ctx, runtimeInfo); }
+    static bool restart(context<N>& ctx, SA_policy<soln<N>>& runtimeInfo){ return restartSearch(ctx, runtimeInfo); }
+    static void saveState(context<N>& ctx, SA_snapshotWriter& writer){ Schwefel::saveState(ctx, writer); }
+    static void loadState(context<N>& ctx, SA_snapshotReader& reader){ Schwefel::loadState(ctx, reader); }
+    static void shareBudget(context<N>& ctx, int numParts){ Schwefel::shareBudget(ctx, numParts); }
 };
 
 } // namespace Schwefel
@@ -0,0 +1,92 @@
+import json
+import os
+import socket
+import subprocess
+import sys
+import time
+
+# local test client for SA_server, run from the build directory:
+#   python ../Example/SchwefelFunction/server_client.py ./SA_server [socket path]
+# starts the server (reading stdin, or listening on the socket), sends it a few jobs and checks the events:
+# two jobs with the same seed give the same result, a seed above 2^24 comes back exactly, a long job stops at its time budget with progress events on the
+# way, so does one with a long initial temperature search, a cancelled job stops early and a job sent after the
+# shutdown request is not run. Exits with 1 if a check fails
+
+if len(sys.argv) < 2:
+    print("usage: server_client.py <SA_server> [socket path]")
+    sys.exit(0)
+
+parameters = os.path.join(os.path.dirname(os.path.abspath(__file__)), "parameters.json")
+command = [sys.argv[1], "--parameters", parameters, "--threads", "2"]
+socket_path = sys.argv[2] if len(sys.argv) > 2 else None
+
+if socket_path:
+    server = subprocess.Popen(command + ["--socket", socket_path])
+    client = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    for _ in range(100):
+        try:
+            client.connect(socket_path)
+            break
+        except OSError:
+            time.sleep(0.05)
+    requests = client.makefile("w")
+    events = client.makefile("r")
+else:
+    server = subprocess.Popen(command, stdin=subprocess.PIPE, stdout=subprocess.PIPE, text=True)
+    requests = server.stdin
+    events = server.stdout
+
+
+def send(request):
+    requests.write(json.dumps(request) + "\n")
+    requests.flush()
+
+
+long_run = {"max eval": 1e9, "max iterations": 1e9, "max temperature steps": 1e9}
+send({"id": "a", "seed": 1})
+send({"id": "b", "seed": 1})
+send({"id": "large seed", "seed": 123456789})
+send({"id": "budget", "seed": 2, "parameters": long_run, "time budget": 0.5, "progress interval": 0.1})
+send({"id": "cancelled", "seed": 3, "parameters": long_run})
+send({"id": "search budget", "seed": 4, "parameters": dict(long_run, **{"initial search size": 3e8}), "time budget": 0.2})
+time.sleep(0.2)
+send({"cancel": "cancelled"})
+
+results = {}
+progress = {}
+start = time.time()
+while len(results) < 6 and time.time() - start < 30:
+    line = events.readline()
+    if not line:
+        break
+    event = json.loads(line)
+    if event["event"] == "result":
+        results[event["id"]] = event
+        print(event["id"], event["status"], "best f", event["best f"], "iterations", event["iterations"],
+              "%.1f ms" % event["runtime ms"])
+    elif event["event"] == "progress":
+        progress[event["id"]] = progress.get(event["id"], 0) + 1
+    elif event["event"] == "error":
+        print("error:", event)
+
+# in one write, so the server reads the job with the shutdown
+requests.write(json.dumps({"shutdown": True}) + "\n" + json.dumps({"id": "after shutdown", "seed": 5}) + "\n")
+requests.flush()
+requests.close()
+late_events = [json.loads(line) for line in events]
+server.wait(timeout=30)
+
+checks = {
+    "every job has a result": len(results) == 6,
+    "same seed, same result": results.get("a", {}).get("best x") == results.get("b", {}).get("best x"),
+    "the seed comes back exactly": results.get("large seed", {}).get("seed") == 123456789,
+    "time budget stops the job": results.get("budget", {}).get("status") == "time budget",
+    "progress events are sent": progress.get("budget", 0) >= 2,
+    "cancel stops the job": results.get("cancelled", {}).get("status") == "cancelled",
+    "time budget stops the initial search": results.get("search budget", {}).get("status") == "time budget"
+                                            and results.get("search budget", {}).get("iterations") == 0,
+    "no job runs after a shutdown": all(event.get("id") != "after shutdown" for event in late_events),
+}
+for name, ok in checks.items():
+    print(("ok     " if ok else "FAILED ") + name)
+sys.exit(0 if all(checks.values()) else 1)
@@ -0,0 +1,317 @@
+#ifndef INCLUDE_TSP
+#define INCLUDE_TSP
+
+#include "../../lib/engine.hpp"
+#include "../../lib/estimate.hpp"
+#include <cmath>
+#include <numeric>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// travelling salesman on random cities in the unit square, annealed with 2-opt moves done in place on the tour
+// (see the in-place policies in engine.hpp). Nothing is copied or allocated per iteration. The length change of a
+// move only looks at its four cities, so a rejected move costs the same whatever the number of cities; an accepted
+// one reverses up to half of the tour
+namespace TSP
+{
+class tour
+{
+private:
+    std::vector<int> _order; // cities in the order they are visited, the tour returns from the last to the first
+    double _length;
+
+public:
+    tour(int numCities = 0) : _order(numCities), _length(0)
+    {   // visits the cities in the order of their index
+        std::iota(_order.begin(), _order.end(), 0);
+    }
+
+    int size(){ return _order.size(); }
+
+    int city(int pos){ return _order[pos]; }
+
+    std::vector<int>& order(){ return _order; }
+
+    double length(){ return _length; }
+
+    void setLength(double length){ _length = length; }
+
+    // for the recorders: the cities in order, followed by the length
+    float getX(int i){ return _order[i]; }
+
+    float getEval(){ return _length; }
+
+    void reverse(int first, int last)
+    {   // reverses the positions first..last, going round the end of the tour if last < first
+        int n = _order.size();
+        int len = (last - first + n) % n + 1;
+        for(int k=0; k<len/2; k++) std::swap(_order[(first + k) % n], _order[(last - k + n) % n]);
+    }
+
+    void save(SA_snapshotWriter& writer)
+    {   // for snapshots: number of cities, order and length
+        writer.write(size());
+        writer.writeBytes(_order.data(), _order.size() * sizeof(int));
+        writer.write(_length);
+    }
+
+    void load(SA_snapshotReader& reader)
+    {
+        int n;
+        reader.read(n);
+        _order.resize(n);
+        reader.readBytes(_order.data(), n * sizeof(int));
+        reader.read(_length);
+    }
+
+    friend std::ostream& operator<< (std::ostream& stream, const tour& t)
+    {   // for printing out the contents of a tour
+        for(int c : t._order) stream << c << ", ";
+        stream << t._length;
+        return stream;
+    }
+
+    std::string print()
+    {   // the length only, tours are too long to print
+        std::stringstream ss;
+        ss << _order.size() << " cities, length: " << _length;
+        return ss.str();
+    }
+};
+
+struct params
+{   // typed copy of parameters.json
+    int numCities;
+    int citySeed; // the cities are placed at random with this seed, independently of the seed of the run
+    int initialSearchSize;
+    float temperatureScaling;
+    int maxSameTempChain;
+    int minAcceptedEachTemp;
+    int maxTempSteps;
+    int restartThreshold;
+};
+
+params parseParameters(std::unordered_map<std::string, float>& parameters)
+{
+    if(parameters["initial search size"] < 2)
+        throw std::runtime_error("the initial search needs an \"initial search size\" of at least 2 moves");
+    return {
+        .numCities = static_cast<int>(parameters["cities"]),
+        .citySeed = parameters.count("city seed") ? static_cast<int>(parameters["city seed"]) : 0,
+        .initialSearchSize = static_cast<int>(parameters["initial search size"]),
+        .temperatureScaling = parameters["temperature scaling"],
+        .maxSameTempChain = static_cast<int>(parameters["max same temperature chain"]),
+        .minAcceptedEachTemp = static_cast<int>(parameters["min accepted at each temperature"]),
+        .maxTempSteps = static_cast<int>(parameters["max temperature steps"]),
+        .restartThreshold = static_cast<int>(parameters["restart threshold"])
+    };
+}
+
+struct context
+{
+    params parameters;
+    std::vector<float> x; // coordinates of the cities
+    std::vector<float> y;
+    SA_random randomGen; // split from the stream of the engine
+    long numMoves = 0; // moves proposed
+};
+
+struct twoOptMove
+{   // removes the edges after positions i and j (i < j) and reconnects the tour by reversing the cities in between
+    int i = 0;
+    int j = 0;
+    double lengthChange = 0;
+};
+
+context createContext(std::unordered_map<std::string, float>& parameters)
+{
+    context ctx{ .parameters = parseParameters(parameters) };
+    SA_random cityGen(ctx.parameters.citySeed);
+    ctx.x.resize(ctx.parameters.numCities);
+    ctx.y.resize(ctx.parameters.numCities);
+    cityGen.fillUniform(ctx.x.data(), ctx.parameters.numCities, 0, 1);
+    cityGen.fillUniform(ctx.y.data(), ctx.parameters.numCities, 0, 1);
+    return ctx;
+}
+
+double distance(context& ctx, int a, int b)
+{
+    double dx = ctx.x[a] - ctx.x[b];
+    double dy = ctx.y[a] - ctx.y[b];
+    return std::sqrt(dx * dx + dy * dy);
+}
+
+double tourLength(context& ctx, tour& t)
+{
+    double length = 0;
+    for(int pos=0; pos<t.size(); pos++) length += distance(ctx, t.city(pos), t.city((pos + 1) % t.size()));
+    return length;
+}
+
+double lengthChange(context& ctx, tour& t, int i, int j)
+{   // change of the length if the edges after positions i and j are swapped for (city i, city j) and
+    // (city i+1, city j+1)
+    int n = t.size();
+    int a = t.city(i);
+    int b = t.city(i + 1);
+    int c = t.city(j);
+    int d = t.city((j + 1) % n);
+    return distance(ctx, a, c) + distance(ctx, b, d) - distance(ctx, a, b) - distance(ctx, c, d);
+}
+
+void randomPositions(context& ctx, int n, int& i, int& j)
+{   // two distinct positions, i < j
+    i = ctx.randomGen.uniformInt(0, n - 1);
+    j = ctx.randomGen.uniformInt(0, n - 2);
+    if(j >= i) j += 1;
+    if(j < i) std::swap(i, j);
+}
+
+void setRandomGen(context& ctx, SA_random& gen)
+{
+    ctx.randomGen = gen;
+}
+
+SA_policy<tour> initialiseRuntimeInfo(context& ctx)
+{   // the initial temperature is the standard deviation of the length change of random moves
+    tour t{ctx.parameters.numCities};
+    SA_welford stats;
+    for(int k=0; k<ctx.parameters.initialSearchSize; k++)
+    {
+        int i, j;
+        randomPositions(ctx, t.size(), i, j);
+        stats.add(lengthChange(ctx, t, i, j));
+    }
+    return {
+        .temperature = static_cast<float>(stats.stdDev()),
+        .maxChange = tour{}, // unused, the size of a move is not adapted
+        .numAcceptedCurrTemp = 0,
+        .numCurrTemp = 0,
+        .numTempSteps = 1,
+        .numNoProgress = 0
+    };
+}
+
+tour getRandomSolution(context& ctx)
+{   // a random order of the cities (Fisher-Yates shuffle)
+    tour t{ctx.parameters.numCities};
+    for(int pos=t.size()-1; pos>0; pos--) std::swap(t.order()[pos], t.order()[ctx.randomGen.uniformInt(0, pos)]);
+    t.setLength(tourLength(ctx, t));
+    return t;
+}
+
+void getNewMove(context& ctx, SA_policy<tour>& runtimeInfo, tour& currSoln, twoOptMove& move)
+{
+    randomPositions(ctx, currSoln.size(), move.i, move.j);
+    ctx.numMoves += 1;
+}
+
+void reverseSegment(tour& t, twoOptMove& move)
+{   // reversing positions i+1..j or the rest of the tour gives the same tour (travelled the other way round), the
+    // shorter of the two is reversed
+    if(2 * (move.j - move.i) <= t.size()) t.reverse(move.i + 1, move.j);
+    else t.reverse(move.j + 1, move.i);
+}
+
+float moveDelta(context& ctx, twoOptMove& move, tour& currSoln)
+{
+    move.lengthChange = lengthChange(ctx, currSoln, move.i, move.j);
+    return move.lengthChange;
+}
+
+void doMove(context& ctx, twoOptMove& move, tour& currSoln)
+{   // only accepted moves are done, with the length change moveDelta computed
+    reverseSegment(currSoln, move);
+    currSoln.setLength(currSoln.length() + move.lengthChange);
+}
+
+float acceptProbability(context& ctx, SA_policy<tour>& runtimeInfo, twoOptMove& move, float lengthChange)
+{   // shorter tours are always accepted
+    return lengthChange <= 0 ? 1 : std::exp(-lengthChange / runtimeInfo.temperature);
+}
+
+void updateRuntimeInfo(context& ctx, SA_policy<tour>& runtimeInfo, twoOptMove& move, tour& currSoln, bool accepted)
+{
+    if(accepted)
+    {
+        runtimeInfo.numAcceptedCurrTemp += 1;
+        runtimeInfo.numCurrTemp += 1;
+        runtimeInfo.numNoProgress = 0;
+    }else
+    {
+        runtimeInfo.numCurrTemp += 1;
+        runtimeInfo.numNoProgress += 1;
+    }
+    if((runtimeInfo.numAcceptedCurrTemp > ctx.parameters.minAcceptedEachTemp) |
+       (runtimeInfo.numCurrTemp > ctx.parameters.maxSameTempChain))
+    {   // desired length of markov chain at current temperature is reached
+        runtimeInfo.temperature *= ctx.parameters.temperatureScaling;
+        runtimeInfo.numTempSteps += 1;
+        runtimeInfo.numAcceptedCurrTemp = 0;
+        runtimeInfo.numCurrTemp = 0;
+    }
+}
+
+bool endSearch(context& ctx, SA_policy<tour>& runtimeInfo)
+{
+    return runtimeInfo.numTempSteps > ctx.parameters.maxTempSteps;
+}
+
+bool restartSearch(context& ctx, SA_policy<tour>& runtimeInfo)
+{   // restarts if there has been no progress for more iterations than threshold
+    return runtimeInfo.numNoProgress > ctx.parameters.restartThreshold;
+}
+
+void saveState(context& ctx, SA_snapshotWriter& writer)
+{
+    writer.write(ctx.randomGen);
+    writer.write(ctx.numMoves);
+}
+
+void loadState(context& ctx, SA_snapshotReader& reader)
+{
+    reader.read(ctx.randomGen);
+    reader.read(ctx.numMoves);
+}
+
+// the problem policy for SA_engine, with in-place moves
+struct Problem
+{
+    using soln_type = tour;
+    using context_type = context;
+    using move_type = twoOptMove;
+
+    static context createContext(std::unordered_map<std::string, float>& parameters){ return TSP::createContext(parameters); }
+    static void setRandomGenerator(context& ctx, SA_random& gen){ setRandomGen(ctx, gen); }
+    static SA_policy<tour> initRuntimeInfo(context& ctx){ return initialiseRuntimeInfo(ctx); }
+    static tour getRandomSolution(context& ctx){ return TSP::getRandomSolution(ctx); }
+    static void getNewMove(context& ctx, SA_policy<tour>& runtimeInfo, tour& currSoln, twoOptMove& move)
+    {
+        TSP::getNewMove(ctx, runtimeInfo, currSoln, move);
+    }
+    static float moveDelta(context& ctx, twoOptMove& move, tour& currSoln){ return TSP::moveDelta(ctx, move, currSoln); }
+    static void doMove(context& ctx, twoOptMove& move, tour& currSoln){ TSP::doMove(ctx, move, currSoln); }
+    static float acceptProbability(context& ctx, SA_policy<tour>& runtimeInfo, twoOptMove& move, float lengthChange)
+    {
+        return TSP::acceptProbability(ctx, runtimeInfo, move, lengthChange);
+    }
+    static void updateRuntimeInfo(context& ctx, SA_policy<tour>& runtimeInfo, twoOptMove& move, tour& currSoln, bool accepted)
+    {
+        TSP::updateRuntimeInfo(ctx, runtimeInfo, move, currSoln, accepted);
+    }
+    static bool compareSoln(context& ctx, tour& betterSoln, tour& worseSoln){ return betterSoln.length() < worseSoln.length(); }
+    static float getEnergy(context& ctx, tour& t){ return t.length(); }
+    static bool endSearch(context& ctx, SA_policy<tour>& runtimeInfo){ return TSP::endSearch(ctx, runtimeInfo); }
+    static bool restart(context& ctx, SA_policy<tour>& runtimeInfo){ return restartSearch(ctx, runtimeInfo); }
+    static void saveState(context& ctx, SA_snapshotWriter& writer){ TSP::saveState(ctx, writer); }
+    static void loadState(context& ctx, SA_snapshotReader& reader){ TSP::loadState(ctx, reader); }
+};
+
+} // namespace TSP
+
+#endif // INCLUDE_TSP
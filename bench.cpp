@@ -0,0 +1,395 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "lib/core.hpp"
+#include "third_party/nlohmann/json.hpp"
+#include "Example/SchwefelFunction/problem.hpp"
+
+// micro benchmarks of the pieces of the annealing loop (objective, neighbour generation, acceptance, random
+// generator, a whole step, and the solution layouts against the one of the hard-coded dimension build) and macro benchmarks of whole optimisations (time to target and success rate against
+// wall clock time on fixed seeds), written to json so that the output of two builds can be compared.
+// usage: SA_bench <parameters.json> <output.json> [quick]
+
+const int numSamples = 1024; // solutions cycled through by the micro benchmarks
+const float targetFraction = 0.95; // a run reaches the target when its best f is within 5% of the global minimum
+const long seedsPerRun = 1 << 16; // macro benchmark runs restart from disjoint ranges of seeds
+const int stepsPerCheck = 64; // steps between two looks at the clock in the macro benchmarks
+
+volatile float sink; // results of the benchmarked calls end up here so they are not optimised away
+
+struct benchConfig
+{
+    double minSeconds; // time spent in each micro benchmark
+    int numSeeds; // runs of each macro benchmark
+    double budgetMs; // wall clock budget of each run
+};
+
+const int callsPerBlock = 256; // calls timed together
+
+struct loopTiming
+{
+    long numCalls = 0;
+    double totalNs = 0;
+    double fastestBlockNs = std::numeric_limits<double>::max();
+};
+
+template <typename F>
+loopTiming timeBlocks(double minSeconds, F&& op)
+{   // calls op in blocks until minSeconds have passed
+    loopTiming t;
+    while(t.totalNs < minSeconds * 1e9)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for(int i=0; i<callsPerBlock; i++) op(t.numCalls + i);
+        double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        t.totalNs += elapsed;
+        t.fastestBlockNs = std::min(t.fastestBlockNs, elapsed);
+        t.numCalls += callsPerBlock;
+    }
+    return t;
+}
+
+nlohmann::json timingResult(const std::string& name, int dimension, int opsPerCall, const loopTiming& t)
+{   // reports the mean and the fastest block in ns per op
+    double numOps = static_cast<double>(t.numCalls) * opsPerCall;
+    std::cout << name << " (dimension " << dimension << "): " << t.totalNs / numOps << " ns\n";
+    return {
+        {"name", name},
+        {"dimension", dimension},
+        {"ns per op", t.totalNs / numOps},
+        {"fastest ns per op", t.fastestBlockNs / (static_cast<double>(callsPerBlock) * opsPerCall)},
+        {"ops", numOps}
+    };
+}
+
+template <typename F>
+nlohmann::json timeLoop(const std::string& name, int dimension, double minSeconds, int opsPerCall, F&& op)
+{
+    return timingResult(name, dimension, opsPerCall, timeBlocks(minSeconds, op));
+}
+
+std::unordered_map<std::string, float> benchParameters(std::unordered_map<std::string, float> jmap, int dimension)
+{   // the parameters of the file with a fixed seed, and stopping conditions left to the benchmark
+    jmap["dimension"] = dimension;
+    jmap["seed"] = 0;
+    jmap["verbose"] = 0;
+    jmap["max eval"] = 1e9;
+    jmap["max iterations"] = 1e15;
+    jmap["max temperature steps"] = 1e9;
+    return jmap;
+}
+
+template <int N>
+void microBenchmarks(std::unordered_map<std::string, float>& jmap, int dimension, const benchConfig& config,
+                     nlohmann::json& out)
+{
+    auto parameters = benchParameters(jmap, dimension);
+    Schwefel::context<N> ctx = Schwefel::createContext<N>(parameters);
+    SA_random gen(0);
+    Schwefel::setRandomGen(ctx, gen);
+    SA_policy<Schwefel::soln<N>> runtimeInfo = Schwefel::initialiseRuntimeInfo(ctx);
+    std::vector<Schwefel::soln<N>> samples;
+    for(int j=0; j<numSamples; j++) samples.push_back(Schwefel::getRandomSolution(ctx));
+    std::vector<Schwefel::soln<N>> neighbours;
+    for(int j=0; j<numSamples; j++) neighbours.push_back(Schwefel::getNewSolution(ctx, runtimeInfo, samples[j]));
+    auto sample = [&samples](long i) -> Schwefel::soln<N>& { return samples[i % numSamples]; };
+
+    // objective
+    out.push_back(timeLoop("objective full", dimension, config.minSeconds, 1, [&](long i)
+    {
+        sample(i).doEval();
+        sink = sample(i).getEval();
+    }));
+    Schwefel::solnBatch& batch = ctx.batch;
+    batch.resize(batch.capacity());
+    for(int j=0; j<batch.size(); j++)
+        for(int i=0; i<dimension; i++) batch.coords(i)[j] = samples[j].getX(i);
+    out.push_back(timeLoop("objective batch " + Schwefel::kernelName(ctx.kernel), dimension, config.minSeconds,
+                           batch.size(), [&](long i)
+    {
+        batch.evaluate(ctx.kernel, ctx.parameters.minXi, ctx.parameters.maxXi);
+        sink = batch.getEval(0);
+    }));
+    Schwefel::coordMove<N> move;
+    ctx.parameters.moveCoordinates = 1;
+    Schwefel::getNewMove(ctx, runtimeInfo, samples[0], move);
+    out.push_back(timeLoop("objective delta 1 coordinate", dimension, config.minSeconds, 1, [&](long i)
+    {
+        Schwefel::deltaEvaluate(ctx, move, sample(i));
+        sink = move.newEval;
+    }));
+
+    // neighbour generation
+    out.push_back(timeLoop("neighbour full solution", dimension, config.minSeconds, 1, [&](long i)
+    {
+        sink = Schwefel::getNewSolution(ctx, runtimeInfo, sample(i)).getEval();
+    }));
+    out.push_back(timeLoop("neighbour move 1 coordinate", dimension, config.minSeconds, 1, [&](long i)
+    {
+        Schwefel::getNewMove(ctx, runtimeInfo, sample(i), move);
+        sink = move.newX[0];
+    }));
+
+    // acceptance
+    out.push_back(timeLoop("accept full solution", dimension, config.minSeconds, 1, [&](long i)
+    {
+        sink = Schwefel::acceptProbability(ctx, runtimeInfo, neighbours[i % numSamples], sample(i));
+    }));
+    Schwefel::deltaEvaluate(ctx, move, samples[0]);
+    out.push_back(timeLoop("accept move 1 coordinate", dimension, config.minSeconds, 1, [&](long i)
+    {
+        sink = Schwefel::acceptProbability(ctx, runtimeInfo, move, samples[0]);
+    }));
+
+    // a whole step of the annealing loop
+    parameters["move coordinates"] = 0;
+    SA_engine<Schwefel::Problem<N>> fullEngine(parameters);
+    fullEngine.initialise();
+    out.push_back(timeLoop("step policy full solution", dimension, config.minSeconds, 1, [&](long i){ fullEngine.step(); }));
+    parameters["move coordinates"] = 1;
+    SA_engine<Schwefel::Problem<N>> moveEngine(parameters);
+    moveEngine.initialise();
+    out.push_back(timeLoop("step policy move 1 coordinate", dimension, config.minSeconds, 1, [&](long i){ moveEngine.step(); }));
+    SA<Schwefel::soln<N>, Schwefel::context<N>, SA_nullRecorder<Schwefel::soln<N>>> compatEngine(Schwefel::problemCtx<N>, parameters);
+    compatEngine.initialise();
+    out.push_back(timeLoop("step compat full solution", dimension, config.minSeconds, 1, [&](long i){ compatEngine.step(); }));
+}
+
+void rngBenchmarks(const benchConfig& config, nlohmann::json& out)
+{
+    std::mt19937 mt(0);
+    out.push_back(timeLoop("rng mt19937", 0, config.minSeconds, 1, [&](long i){ sink = mt(); }));
+    std::uniform_real_distribution<float> urand{-1.0, 1.0};
+    out.push_back(timeLoop("rng mt19937 uniform float", 0, config.minSeconds, 1, [&](long i){ sink = urand(mt); }));
+    SA_random gen(0);
+    out.push_back(timeLoop("rng xoshiro256++", 0, config.minSeconds, 1, [&](long i){ sink = gen.next(); }));
+    out.push_back(timeLoop("rng buffered uniform float", 0, config.minSeconds, 1, [&](long i){ sink = gen.uniform(-1, 1); }));
+}
+
+// the solution layout of the build that had the dimension hard-coded (#define DIMENSION 6 in problem.hpp), kept as
+// the reference the soln<N> layouts are timed against. Only the global evaluation counter is left out, the context
+// counts the evaluations now
+const int referenceDimension = 6;
+
+class referenceSoln
+{
+private:
+    float x[referenceDimension];
+    float f;
+    float _lbound;
+    float _ubound;
+
+    float evaluateObjective()
+    {
+        float tmp = 0;
+        for(int i=0; i<referenceDimension; i++)
+        {
+            if(x[i] < _lbound | x[i] > _ubound) return std::numeric_limits<float>::max(); // solution is outside constraints
+            tmp -= x[i] * std::sin(std::sqrt(std::fabs(x[i])));
+        }
+        return tmp;
+    }
+
+public:
+    referenceSoln(int dim, float lowerbound, float upperbound)
+    {
+        _lbound = lowerbound;
+        _ubound = upperbound;
+        for(int i=0; i<referenceDimension; i++) x[i] = 0;
+        f = 0;
+    }
+
+    void doEval(){ f = evaluateObjective(); }
+
+    float getEval(){ return f; }
+
+    int size(){ return referenceDimension; }
+
+    float getX(int i){ return x[i]; }
+
+    void setX(int i, float val){ x[i]=val; }
+};
+
+template <typename S>
+struct layoutSamples
+{   // the same solutions on every layout, and the coordinates their neighbours get
+    std::vector<S> samples;
+    std::vector<float> newX;
+
+    layoutSamples(float minXi, float maxXi) : samples(numSamples, S{referenceDimension, minXi, maxXi}), newX(numSamples)
+    {
+        SA_random gen(0);
+        for(int j=0; j<numSamples; j++)
+        {
+            for(int i=0; i<referenceDimension; i++) samples[j].setX(i, gen.uniform(minXi, maxXi));
+            samples[j].doEval();
+            newX[j] = gen.uniform(minXi, maxXi);
+        }
+    }
+
+    void objective(long i)
+    {
+        S& s = samples[i % numSamples];
+        s.doEval();
+        sink = s.getEval();
+    }
+
+    void neighbour(long i)
+    {   // as getNewSolution does, without the random draws: copy, change a coordinate and evaluate
+        S s = samples[i % numSamples];
+        s.setX(i % referenceDimension, newX[i % numSamples]);
+        s.doEval();
+        sink = s.getEval();
+    }
+};
+
+void layoutBenchmarks(std::unordered_map<std::string, float>& jmap, const benchConfig& config, nlohmann::json& out)
+{   // the reference layout, soln<N> and soln<0> take turns over a few rounds and each keeps its fastest round, so
+    // a slow spell of the machine does not fall on one of them only. compare_bench.py checks the soln<N> entries
+    // against the reference ones of the same build
+    const int numRounds = 5;
+    layoutSamples<referenceSoln> reference(jmap["min xi"], jmap["max xi"]);
+    layoutSamples<Schwefel::soln<referenceDimension>> fixed(jmap["min xi"], jmap["max xi"]);
+    layoutSamples<Schwefel::soln<0>> dynamic(jmap["min xi"], jmap["max xi"]);
+    auto timeLayouts = [&](const std::string& operation, auto&& opOf)
+    {
+        loopTiming best[3];
+        auto keepFaster = [](loopTiming& best, const loopTiming& t)
+        {
+            if(best.numCalls == 0 || t.totalNs / t.numCalls < best.totalNs / best.numCalls) best = t;
+        };
+        for(int r=0; r<numRounds; r++)
+        {
+            keepFaster(best[0], timeBlocks(config.minSeconds / numRounds, opOf(reference)));
+            keepFaster(best[1], timeBlocks(config.minSeconds / numRounds, opOf(fixed)));
+            keepFaster(best[2], timeBlocks(config.minSeconds / numRounds, opOf(dynamic)));
+        }
+        out.push_back(timingResult("layout " + operation + " reference", referenceDimension, 1, best[0]));
+        out.push_back(timingResult("layout " + operation + " soln<N>", referenceDimension, 1, best[1]));
+        out.push_back(timingResult("layout " + operation + " soln<0>", referenceDimension, 1, best[2]));
+    };
+    timeLayouts("objective", [](auto& layout){ return [&layout](long i){ layout.objective(i); }; });
+    timeLayouts("neighbour", [](auto& layout){ return [&layout](long i){ layout.neighbour(i); }; });
+}
+
+template <int N>
+nlohmann::json macroBenchmark(std::unordered_map<std::string, float>& jmap, int dimension, int moveCoordinates,
+                              const benchConfig& config)
+{   // run r restarts the optimisation (with the stopping conditions of the parameter file) from the seeds
+    // r * seedsPerRun, r * seedsPerRun + 1, .. until its best f reaches the target or the wall clock budget runs out
+    std::unordered_map<std::string, float> parameters = jmap;
+    parameters["dimension"] = dimension;
+    parameters["verbose"] = 0;
+    parameters["move coordinates"] = moveCoordinates;
+    float target = targetFraction * dimension * -418.9829f; // the global minimum is -418.9829 per coordinate
+    std::vector<double> timesToTarget; // of the runs that reached the target, in ms
+    std::vector<float> bestEvals;
+    long numRestarts = 0;
+    for(int r=0; r<config.numSeeds; r++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        float bestEval = std::numeric_limits<float>::max();
+        bool done = false;
+        for(long seed=r*seedsPerRun; !done; seed++)
+        {
+            parameters["seed"] = seed;
+            SA_engine<Schwefel::Problem<N>> SAinst(parameters);
+            SAinst.initialise();
+            numRestarts += 1;
+            while(!SAinst.isFinished() && !done)
+            {
+                for(int i=0; i<stepsPerCheck && !SAinst.isFinished(); i++) SAinst.step();
+                double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                bestEval = std::min(bestEval, SAinst.getOptimisationResult().second.getEval());
+                if(bestEval <= target) timesToTarget.push_back(elapsed);
+                done = bestEval <= target || elapsed > config.budgetMs;
+            }
+        }
+        bestEvals.push_back(bestEval);
+    }
+    std::sort(timesToTarget.begin(), timesToTarget.end());
+
+    nlohmann::json successVsTime = nlohmann::json::array();
+    for(double fraction=1.0/64; fraction<=1; fraction*=2)
+    {
+        double t = fraction * config.budgetMs;
+        long numReached = std::upper_bound(timesToTarget.begin(), timesToTarget.end(), t) - timesToTarget.begin();
+        successVsTime.push_back({{"ms", t}, {"success rate", static_cast<double>(numReached) / config.numSeeds}});
+    }
+    auto percentile = [&timesToTarget](double p)
+    {
+        return timesToTarget.empty() ? -1.0 : timesToTarget[std::lround(p * (timesToTarget.size() - 1))];
+    };
+    double meanBest = 0;
+    for(float f : bestEvals) meanBest += f / bestEvals.size();
+    std::cout << "time to target (dimension " << dimension << ", move coordinates " << moveCoordinates << "): "
+              << timesToTarget.size() << "/" << config.numSeeds << " runs, median " << percentile(0.5) << "ms\n";
+    return {
+        {"dimension", dimension},
+        {"move coordinates", moveCoordinates},
+        {"runs", config.numSeeds},
+        {"budget ms", config.budgetMs},
+        {"target f", target},
+        {"success rate", static_cast<double>(timesToTarget.size()) / config.numSeeds},
+        {"time to target ms", {{"p50", percentile(0.5)}, {"p90", percentile(0.9)}, {"max", percentile(1)}}},
+        {"success vs time", successVsTime},
+        {"mean best f", meanBest},
+        {"optimisations", numRestarts}
+    };
+}
+
+int main(int argc,
+         char *argv[]) {
+    if(argc<3)
+    {
+        std::cout << "usage: SA_bench <parameters.json> <output.json> [quick]\n";
+        return 0;
+    }
+    std::ifstream f(argv[1]);
+    nlohmann::json data = nlohmann::json::parse(f);
+    auto jmap = data.get<std::unordered_map<std::string, float>>();
+    bool quick = argc>3 && std::string(argv[3]) == "quick";
+    benchConfig config = quick ? benchConfig{0.05, 5, 50} : benchConfig{0.2, 20, 200};
+
+    nlohmann::json out;
+    out["build"] = {
+        {"compiler", __VERSION__},
+#ifdef NDEBUG
+        {"assertions", false},
+#else
+        {"assertions", true},
+#endif
+        {"kernel", Schwefel::kernelName(Schwefel::bestKernel())},
+        {"quick", quick}
+    };
+    out["micro"] = nlohmann::json::array();
+    rngBenchmarks(config, out["micro"]);
+    layoutBenchmarks(jmap, config, out["micro"]);
+    for(int dimension : {6, 32, 100})
+    {
+        Schwefel::withDimension(dimension, [&](auto n)
+        {
+            microBenchmarks<decltype(n)::value>(jmap, dimension, config, out["micro"]);
+        });
+    }
+    out["macro"] = nlohmann::json::array();
+    for(int dimension : {6, 16, 32})
+    {
+        Schwefel::withDimension(dimension, [&](auto n)
+        {
+            for(int moveCoordinates : {0, 1})
+                out["macro"].push_back(macroBenchmark<decltype(n)::value>(jmap, dimension, moveCoordinates, config));
+        });
+    }
+
+    std::ofstream outfile(argv[2], std::ios::out|std::ios::trunc);
+    outfile << out.dump(4) << '\n';
+    std::cout << "results saved to " << argv[2] << '\n';
+    return 0;
+}
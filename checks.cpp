@@ -0,0 +1,148 @@
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include "lib/engine.hpp"
+#include "third_party/nlohmann/json.hpp"
+#include "Example/SchwefelFunction/problem.hpp"
+
+// checks of the guarantees the optimiser makes about reproducing runs, run by ctest.
+// usage: SA_checks <parameters.json> <determinism | resume>
+//   determinism   a seed gives the same run twice, whatever the number of speculative threads or of initial search
+//                 threads
+//   resume        a run resumed from a snapshot ends the same as the run that wrote the snapshot
+// Exits with 1 if a check fails. The kernel tolerance is checked by SA_kernels
+
+using engine_type = SA_engine<Schwefel::Problem<6>>;
+
+const uint64_t checkSeed = 42;
+const char* snapshotFile = "checks_snapshot.bin";
+
+struct runResult
+{
+    Schwefel::soln<6> curr;
+    Schwefel::soln<6> best;
+    long numIterations;
+    long numEvaluations;
+    float initialTemperature; // not in a snapshot, a resumed run does not estimate it again
+    float temperature;
+};
+
+bool sameSoln(Schwefel::soln<6>& a, Schwefel::soln<6>& b)
+{   // bit for bit, not within a tolerance
+    if(a.size() != b.size() || a.getEval() != b.getEval()) return false;
+    for(int i=0; i<a.size(); i++)
+        if(a.getX(i) != b.getX(i)) return false;
+    return true;
+}
+
+bool sameRun(runResult& a, runResult& b)
+{
+    return sameSoln(a.curr, b.curr) && sameSoln(a.best, b.best) && a.numIterations == b.numIterations
+        && a.numEvaluations == b.numEvaluations && a.temperature == b.temperature;
+}
+
+runResult getResult(engine_type& SAinst)
+{
+    std::pair<Schwefel::soln<6>, Schwefel::soln<6>> result = SAinst.getOptimisationResult();
+    return {result.first, result.second, SAinst.getNumIterations(), SAinst.getContext().num_of_evaluations,
+            SAinst.getContext().initialTemperature, SAinst.getRuntimeInfo().temperature};
+}
+
+runResult runWith(std::unordered_map<std::string, float> jmap)
+{
+    SA_settings settings = SA_settings::fromParameters(jmap);
+    settings.seed = checkSeed;
+    settings.verbose = false;
+    engine_type SAinst(Schwefel::createContext<6>(jmap), settings);
+    SAinst.optimise();
+    return getResult(SAinst);
+}
+
+bool report(const std::string& name, bool ok)
+{
+    std::cout << (ok ? "ok     " : "FAILED ") << name << '\n';
+    return ok;
+}
+
+bool checkDeterminism(std::unordered_map<std::string, float>& jmap)
+{
+    bool allPassed = true;
+    runResult reference = runWith(jmap);
+    runResult again = runWith(jmap);
+    allPassed &= report("same seed, same run", sameRun(reference, again));
+
+    std::unordered_map<std::string, float> searchThreads = jmap;
+    searchThreads["initial search size"] = 20000;
+    runResult oneThread = runWith(searchThreads);
+    searchThreads["initial search threads"] = 3;
+    runResult threeThreads = runWith(searchThreads);
+    // runs from different initial temperatures can still end the same, so the estimates are compared too
+    allPassed &= report("same run whatever the initial search threads", sameRun(oneThread, threeThreads)
+                        && oneThread.initialTemperature == threeThreads.initialTemperature);
+
+    std::unordered_map<std::string, float> speculative = jmap;
+    speculative["proposals per step"] = 8;
+    runResult serial = runWith(speculative);
+    speculative["speculative threads"] = 3;
+    runResult parallel = runWith(speculative);
+    allPassed &= report("same run whatever the speculative threads", sameRun(serial, parallel));
+    return allPassed;
+}
+
+bool checkResume(std::unordered_map<std::string, float>& jmap)
+{   // the uninterrupted run writes a snapshot part way, as its checkpoints would, and goes on to the end
+    const int snapshotCheck = 5; // the snapshot is written at the 5th call of the monitor
+    SA_settings settings = SA_settings::fromParameters(jmap);
+    settings.seed = checkSeed;
+    settings.verbose = false;
+    engine_type uninterrupted(Schwefel::createContext<6>(jmap), settings);
+    int numChecks = 0;
+    long snapshotIteration = 0;
+    uninterrupted.optimise([&]
+    {
+        if(++numChecks == snapshotCheck)
+        {
+            uninterrupted.saveSnapshot(snapshotFile);
+            snapshotIteration = uninterrupted.getNumIterations();
+        }
+        return true;
+    });
+    runResult reference = getResult(uninterrupted);
+    if(!report("the run goes past the snapshot", snapshotIteration > 0 && reference.numIterations > snapshotIteration))
+        return false;
+
+    engine_type resumed(Schwefel::createContext<6>(jmap), settings);
+    resumed.resume(snapshotFile);
+    runResult result = getResult(resumed);
+    std::remove(snapshotFile);
+    bool allPassed = report("resumed run ends as the uninterrupted one", sameRun(reference, result));
+    allPassed &= report("resumed iterations counted from the snapshot", resumed.getNumResumedIterations() == snapshotIteration);
+    return allPassed;
+}
+
+int main(int argc,
+         char *argv[]) {
+    if(argc<3)
+    {
+        std::cout << "usage: SA_checks <parameters.json> <determinism | resume>\n";
+        return 1;
+    }
+    std::ifstream f(argv[1]);
+    nlohmann::json data = nlohmann::json::parse(f);
+    auto jmap = data.get<std::unordered_map<std::string, float>>();
+    jmap["dimension"] = 6;
+    jmap["max eval"] = 200000; // long enough for the runs to go through several monitor calls
+
+    std::string check = argv[2];
+    bool passed;
+    if(check == "determinism") passed = checkDeterminism(jmap);
+    else if(check == "resume") passed = checkResume(jmap);
+    else
+    {
+        std::cout << "unknown check " << check << '\n';
+        return 1;
+    }
+    return passed ? 0 : 1;
+}
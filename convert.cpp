@@ -0,0 +1,54 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include "lib/recorder.hpp"
+
+// converts a binary trajectory written by SA_streamRecorder into the text files of printAllToFile
+// and printAcceptedToFile, so they can be used by visualise.py
+int main(int argc,
+         char *argv[]) {
+    if(argc<2)
+    {
+        std::cout << "usage: SA_convert <trajectory.bin> [allSolutions.txt] [acceptedSolutions.txt]\n";
+        return 0;
+    }
+    std::string allFile = argc>2 ? argv[2] : "allSolutions.txt";
+    std::string acceptedFile = argc>3 ? argv[3] : "acceptedSolutions.txt";
+
+    std::ifstream infile(argv[1], std::ios::in|std::ios::binary);
+    SA_trajectoryHeader header;
+    if(!infile.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+       std::strncmp(header.magic, "SATR", 4) != 0)
+    {
+        std::cout << argv[1] << " is not a trajectory file\n";
+        return 1;
+    }
+    if(header.version != SA_trajectoryVersion || header.recordSize != SA_trajectoryRecordSize(header.numFields))
+    {
+        std::cout << "unsupported trajectory version " << header.version << '\n';
+        return 1;
+    }
+
+    std::ofstream allOut(allFile, std::ios::out|std::ios::trunc);
+    std::ofstream acceptedOut(acceptedFile, std::ios::out|std::ios::trunc);
+    std::vector<char> record(header.recordSize);
+    std::vector<float> values(header.numFields + 2);
+    long numSteps = 0, numAccepted = 0;
+    while(infile.read(record.data(), record.size()))
+    {
+        uint32_t kind;
+        std::memcpy(&kind, record.data() + sizeof(int64_t), sizeof(kind));
+        std::memcpy(values.data(), record.data() + sizeof(int64_t) + sizeof(kind), values.size() * sizeof(float));
+        // same layout as printAllToFile: [solution], temperature, acceptProb
+        std::ostream& out = kind == SA_stepRecord ? allOut : acceptedOut;
+        int numValues = kind == SA_stepRecord ? values.size() : header.numFields;
+        for(int i=0; i<numValues-1; i++) out << values[i] << ", ";
+        out << values[numValues-1] << '\n';
+        (kind == SA_stepRecord ? numSteps : numAccepted) += 1;
+    }
+    std::cout << numSteps << " iterations written to " << allFile << ", "
+              << numAccepted << " accepted solutions written to " << acceptedFile << '\n';
+    return 0;
+}
@@ -0,0 +1,71 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <chrono>
+#include <algorithm>
+#include "lib/engine.hpp"
+#include "third_party/nlohmann/json.hpp"
+#include "Example/SchwefelFunction/problem.hpp"
+
+// runs the same optimisation with soln<N> and with the runtime dimension layout soln<0>, and reports the best
+// iterations per second of each out of a few repeats. The layout of the build with DIMENSION hard-coded is timed
+// against soln<N> by SA_bench (the "layout" micro benchmarks, checked by compare_bench.py)
+// usage: SA_dimensions <parameters.json> [repeats]
+
+template <int N>
+double iterationsPerSecond(std::unordered_map<std::string, float>& jmap, int repeats, float& bestEval)
+{
+    double best = 0;
+    for(int r=0; r<repeats; r++)
+    {
+        SA_engine<Schwefel::Problem<N>> SAinst(jmap);
+        auto start = std::chrono::steady_clock::now();
+        SAinst.optimise();
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best = std::max(best, SAinst.getNumIterations() / elapsed);
+        bestEval = SAinst.getOptimisationResult().second.getEval();
+    }
+    return best;
+}
+
+int main(int argc,
+         char *argv[]) {
+    if(argc<=1)
+    {
+        std::cout << "usage: SA_dimensions <parameters.json> [repeats]\n";
+        return 0;
+    }
+    std::ifstream f(argv[1]);
+    nlohmann::json data = nlohmann::json::parse(f);
+    auto jmap = data.get<std::unordered_map<std::string, float>>();
+    int repeats = argc>2 ? std::stoi(argv[2]) : 5;
+    if(!jmap.count("seed")) jmap["seed"] = 0; // every run has to do the same iterations
+    jmap["verbose"] = 0;
+
+    bool allMatch = true;
+    std::cout << "dimension, soln<N> it/s, soln<0> it/s, ratio\n";
+    for(int dimension : {2, 4, 6, 8, 16, 32, 12, 100})
+    {
+        jmap["dimension"] = dimension;
+        float dynamicEval = 0;
+        double dynamic = iterationsPerSecond<0>(jmap, repeats, dynamicEval);
+        Schwefel::withDimension(dimension, [&](auto n)
+        {
+            constexpr int N = decltype(n)::value;
+            std::cout << dimension << ", ";
+            if constexpr (N > 0)
+            {   // both layouts make the same random draws, so they have to find the same solutions
+                float fixedEval = 0;
+                double fixed = iterationsPerSecond<N>(jmap, repeats, fixedEval);
+                allMatch &= fixedEval == dynamicEval;
+                std::cout << fixed << ", " << dynamic << ", " << fixed / dynamic << '\n';
+            }else
+            {
+                std::cout << "-, " << dynamic << ", -\n";
+            }
+        });
+    }
+    if(!allMatch) std::cout << "the two layouts found different solutions\n";
+    return allMatch ? 0 : 1;
+}
@@ -0,0 +1,91 @@
+#include <iostream>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include "lib/core.hpp"
+#include "lib/ensemble.hpp"
+#include "lib/json.hpp"
+#include "third_party/nlohmann/json.hpp"
+#include "Example/SchwefelFunction/problem.hpp"
+
+// a run is successful if its best solution is within this l2 distance of the global optimum
+const float l2Limit = 10;
+const int numHistogramBins = 100;
+
+nlohmann::json histogramToJson(SA_histogram& h)
+{
+    return {{"lower", h.lower}, {"upper", h.upper}, {"counts", h.counts}};
+}
+
+int main(int argc,
+         char *argv[]) {
+    if(argc<4)
+    {
+        std::cout << "usage: SA_ensemble <parameters.json> <number of runs> <output.json> [number of threads]\n";
+        return 0;
+    }
+
+    // get the parameter data
+    std::ifstream f(argv[1]);
+    nlohmann::json data = nlohmann::json::parse(f);
+    auto jmap = data.get<std::unordered_map<std::string, float>>();
+    int numRuns = std::stoi(argv[2]);
+    int numThreads = argc>4 ? std::stoi(argv[4]) : std::thread::hardware_concurrency();
+    SA_settings settings = SA_settings::fromParameters(jmap);
+    SA_jsonSeed(data, settings);
+
+    // perform all the SA runs
+    int dimension;
+    try
+    {
+        dimension = Schwefel::parseParameters(jmap).dimension;
+    }catch(const std::runtime_error& error)
+    {   // parameters the problem cannot run with
+        std::cout << error.what() << '\n';
+        return 1;
+    }
+    std::vector<SA_runResult> results;
+    int numThreadsUsed = 0;
+    auto start = std::chrono::steady_clock::now();
+    Schwefel::withDimension(dimension, [&](auto n)
+    {
+        constexpr int N = decltype(n)::value;
+        SA_ensemble<Schwefel::Problem<N>> ensemble(Schwefel::createContext<N>(jmap), settings, numThreads);
+        Schwefel::soln<N> optimum = Schwefel::globalOptimum<N>(dimension);
+        numThreadsUsed = ensemble.numThreads();
+        results = ensemble.run(numRuns, [&optimum](SA_engine<Schwefel::Problem<N>>& SAinst)
+        {
+            Schwefel::soln<N> best = SAinst.getOptimisationResult().second;
+            return Schwefel::l2(best, optimum) < l2Limit;
+        });
+    });
+    auto finish = std::chrono::steady_clock::now();
+    SA_ensembleSummary summary = SA_ensembleSummary::fromResults(results, numHistogramBins);
+
+    // write out the aggregated statistics
+    nlohmann::json out;
+    out["runs"] = summary.numRuns;
+    out["threads"] = numThreadsUsed;
+    out["dimension"] = dimension;
+    out["total time ms"] = std::chrono::duration<double, std::milli>(finish - start).count();
+    out["first seed"] = results.empty() ? 0 : results.front().seed;
+    out["l2 limit"] = l2Limit;
+    out["success rate"] = summary.successRate;
+    out["best f"] = histogramToJson(summary.bestEval);
+    out["current f"] = histogramToJson(summary.currEval);
+    out["runtime ms"] = {
+        {"mean", summary.runtimeMean},
+        {"p50", summary.runtimeP50},
+        {"p90", summary.runtimeP90},
+        {"p99", summary.runtimeP99},
+        {"max", summary.runtimeMax}
+    };
+    std::ofstream outfile(argv[3], std::ios::out|std::ios::trunc);
+    outfile << out.dump(4) << '\n';
+
+    std::cout << "success rate: " << summary.successRate << '\n';
+    std::cout << "mean runtime: " << summary.runtimeMean << "ms\n";
+    std::cout << "results saved to " << argv[3] << '\n';
+    return 0;
+}
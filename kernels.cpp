@@ -0,0 +1,78 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "lib/core.hpp"
+#include "Example/SchwefelFunction/problem.hpp"
+
+// checks every batch kernel of Schwefel's function supported by this cpu against the scalar soln::doEval(),
+// and reports the number of evaluations per second of each kernel. usage: SA_kernels [dimension]
+int main(int argc,
+         char *argv[]) {
+    const int dimension = argc>1 ? std::stoi(argv[1]) : 6;
+    const int numCandidates = 4096;
+    const float lbound = -500;
+    const float ubound = 500;
+    const double minSeconds = 0.5;
+
+    // random candidates, a few of them slightly outside the bounds
+    SA_random gen(0);
+    Schwefel::solnBatch batch{dimension, numCandidates};
+    batch.resize(numCandidates);
+    std::vector<Schwefel::soln<0>> solns(numCandidates, Schwefel::soln<0>{dimension, lbound, ubound, gen});
+    for(int j=0; j<numCandidates; j++)
+    {
+        for(int i=0; i<dimension; i++)
+        {
+            float xi = gen.uniform(lbound * 1.01f, ubound * 1.01f);
+            solns[j].setX(i, xi);
+            batch.coords(i)[j] = xi;
+        }
+        solns[j].doEval();
+    }
+
+    bool allPassed = true;
+    for(Schwefel::evalKernel kernel : {Schwefel::evalKernel::scalar, Schwefel::evalKernel::avx2, Schwefel::evalKernel::avx512})
+    {
+        std::string name = Schwefel::kernelName(kernel);
+        if(!Schwefel::kernelSupported(kernel))
+        {
+            std::cout << name << ": not supported\n";
+            continue;
+        }
+
+        // accuracy against the scalar path
+        batch.evaluate(kernel, lbound, ubound);
+        float maxError = 0;
+        bool boundsMatch = true;
+        for(int j=0; j<numCandidates; j++)
+        {
+            float expected = solns[j].getEval();
+            bool outside = expected == std::numeric_limits<float>::max();
+            boundsMatch &= outside == (batch.getEval(j) == std::numeric_limits<float>::max());
+            if(outside) continue;
+            float sumAbsX = 0;
+            for(int i=0; i<dimension; i++) sumAbsX += std::fabs(solns[j].getX(i));
+            maxError = std::max(maxError, std::fabs(batch.getEval(j) - expected) / sumAbsX);
+        }
+        bool passed = boundsMatch && maxError <= Schwefel::kernelTolerance;
+        allPassed &= passed;
+
+        // throughput
+        long numEvaluations = 0;
+        auto start = std::chrono::steady_clock::now();
+        double elapsed = 0;
+        while(elapsed < minSeconds)
+        {
+            for(int r=0; r<16; r++) batch.evaluate(kernel, lbound, ubound);
+            numEvaluations += 16 * numCandidates;
+            elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        std::cout << name << ": " << numEvaluations / elapsed << " evaluations per second, max error "
+                  << maxError << " * sum|x_i| (tolerance " << Schwefel::kernelTolerance << ") "
+                  << (passed ? "ok" : "FAILED") << '\n';
+    }
+    return allPassed ? 0 : 1;
+}
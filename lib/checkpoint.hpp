@@ -0,0 +1,149 @@
+#ifndef INCLUDE_SA_CHECKPOINT
+#define INCLUDE_SA_CHECKPOINT
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#define SA_HAS_FSYNC
+#endif
+
+// snapshot file layout (in the byte order of the machine that wrote it):
+//   header: char[4] "SASN", uint32 version, uint64 payload size, uint64 FNV-1a hash of the payload
+//   payload: the state of the run, written by SA_engine::saveSnapshot
+// A snapshot is written to fileName.tmp and renamed over fileName, so fileName always holds a complete snapshot
+struct SA_snapshotHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t size;
+    uint64_t hash;
+};
+
+const uint32_t SA_snapshotVersion = 2;
+
+inline uint64_t SA_fnv1a(const char* data, size_t size)
+{
+    uint64_t hash = 0xcbf29ce484222325;
+    for(size_t i=0; i<size; i++) hash = (hash ^ static_cast<unsigned char>(data[i])) * 0x100000001b3;
+    return hash;
+}
+
+class SA_snapshotWriter
+{
+private:
+    std::vector<char> _data;
+
+public:
+    void writeBytes(const void* bytes, size_t size)
+    {
+        const char* p = static_cast<const char*>(bytes);
+        _data.insert(_data.end(), p, p + size);
+    }
+
+    template <typename V>
+    void write(const V& value)
+    {
+        static_assert(std::is_trivially_copyable_v<V>, "only trivially copyable values are written as they are");
+        writeBytes(&value, sizeof(V));
+    }
+
+    // writes the snapshot to fileName.tmp, flushes it to disk and renames it over fileName
+    void commit(const std::string& fileName)
+    {
+        SA_snapshotHeader header{{'S', 'A', 'S', 'N'}, SA_snapshotVersion, _data.size(), SA_fnv1a(_data.data(), _data.size())};
+        std::string tmpName = fileName + ".tmp";
+        FILE* file = std::fopen(tmpName.c_str(), "wb");
+        if(file == nullptr) throw std::runtime_error("cannot write snapshot " + tmpName);
+        bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                  std::fwrite(_data.data(), 1, _data.size(), file) == _data.size() &&
+                  std::fflush(file) == 0;
+#ifdef SA_HAS_FSYNC
+        ok = ok && fsync(fileno(file)) == 0;
+#endif
+        ok = (std::fclose(file) == 0) && ok;
+        if(!ok || std::rename(tmpName.c_str(), fileName.c_str()) != 0)
+            throw std::runtime_error("cannot write snapshot " + fileName);
+    }
+};
+
+class SA_snapshotReader
+{
+private:
+    std::vector<char> _data;
+    size_t _pos;
+
+public:
+    SA_snapshotReader(const std::string& fileName) : _pos(0)
+    {
+        std::ifstream file(fileName, std::ios::in|std::ios::binary);
+        SA_snapshotHeader header;
+        if(!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::memcmp(header.magic, "SASN", 4) != 0)
+            throw std::runtime_error(fileName + " is not a snapshot");
+        if(header.version != SA_snapshotVersion)
+            throw std::runtime_error(fileName + " has snapshot version " + std::to_string(header.version) +
+                                     ", expected " + std::to_string(SA_snapshotVersion));
+        _data.resize(header.size);
+        if(!file.read(_data.data(), header.size) || SA_fnv1a(_data.data(), _data.size()) != header.hash)
+            throw std::runtime_error(fileName + " is corrupted");
+    }
+
+    void readBytes(void* bytes, size_t size)
+    {
+        if(_pos + size > _data.size()) throw std::runtime_error("snapshot ended early");
+        std::memcpy(bytes, _data.data() + _pos, size);
+        _pos += size;
+    }
+
+    template <typename V>
+    void read(V& value)
+    {
+        static_assert(std::is_trivially_copyable_v<V>, "only trivially copyable values are read as they are");
+        readBytes(&value, sizeof(V));
+    }
+};
+
+// how a value (eg. a solution) is written into a snapshot: types with the members
+//   void save(SA_snapshotWriter&)
+//   void load(SA_snapshotReader&)
+// use them, trivially copyable types are copied as they are
+template <typename T, typename = void>
+struct SA_snapshotTraits
+{
+    static void save(SA_snapshotWriter& writer, T& value){ writer.write(value); }
+    static void load(SA_snapshotReader& reader, T& value){ reader.read(value); }
+};
+
+template <typename T>
+struct SA_snapshotTraits<T, std::void_t<decltype(std::declval<T&>().save(std::declval<SA_snapshotWriter&>()))>>
+{
+    static void save(SA_snapshotWriter& writer, T& value){ value.save(writer); }
+    static void load(SA_snapshotReader& reader, T& value){ value.load(reader); }
+};
+
+template <typename T>
+void SA_saveVector(SA_snapshotWriter& writer, std::vector<T>& values)
+{
+    writer.write(static_cast<uint64_t>(values.size()));
+    for(T& v : values) SA_snapshotTraits<T>::save(writer, v);
+}
+
+template <typename T>
+void SA_loadVector(SA_snapshotReader& reader, std::vector<T>& values)
+{
+    uint64_t size;
+    reader.read(size);
+    values.resize(size);
+    for(T& v : values) SA_snapshotTraits<T>::load(reader, v);
+}
+
+#endif // INCLUDE_SA_CHECKPOINT
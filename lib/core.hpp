@@ -1,140 +1,131 @@
 #ifndef INCLUDE_SA_CORE
 #define INCLUDE_SA_CORE
 
+#include <limits>
 #include <random>
 #include <unordered_map>
 #include <string>
-#include <ctime>
-#include <iostream>
-#include <ostream>
-
-template <typename T>
-struct SA_policy
-{
-    float temperature;
-    T maxChange; // for creating new solutions
-    int numAcceptedCurrTemp; // number of solutions accepted at current temperature
-    int numCurrTemp; // number of trials at current temperature
-    int numTempSteps; // number of temperature changes
-    int numNoProgress; // number of iterations where no solution is accepted
-};
+#include <type_traits>
+#include "engine.hpp"
 
 // problem specific methods (to be defined for each optimisation problem)
-template <typename T>
+// C is the per-run context passed to every method. It defaults to the raw parameter map, but a problem
+// can provide createContext to convert the map once into a typed struct before the optimisation starts,
+// and keep any state private to a run (random generator, counters) in it
+template <typename T, typename C = std::unordered_map<std::string, float>>
 struct ProblemCtx
-{   
-    void (*setRandomGenerator)(std::mt19937&) = nullptr;
-    SA_policy<T> (*initRuntimeInfo)(std::unordered_map<std::string, float>&) = nullptr;
-    T (*getRandomSolution)(std::unordered_map<std::string, float>&) = nullptr;
-    T (*getNewSolution)(std::unordered_map<std::string, float>&, SA_policy<T>&, T&) = nullptr;
-    float (*acceptProbability)(std::unordered_map<std::string, float>&, SA_policy<T>&, T&, T&) = nullptr;
-    void (*updateRuntimeInfo)(std::unordered_map<std::string, float>&, SA_policy<T>&, T&, T&, bool)=nullptr;
+{
+    C (*createContext)(std::unordered_map<std::string, float>&) = nullptr;
+    void (*setRandomGenerator)(C&, SA_random&) = nullptr;
+    SA_policy<T> (*initRuntimeInfo)(C&) = nullptr;
+    T (*getRandomSolution)(C&) = nullptr;
+    T (*getNewSolution)(C&, SA_policy<T>&, T&) = nullptr;
+    float (*acceptProbability)(C&, SA_policy<T>&, T&, T&) = nullptr;
+    void (*updateRuntimeInfo)(C&, SA_policy<T>&, T&, T&, bool)=nullptr;
     bool (*compareSoln)(T&, T&) = nullptr;
-    bool (*endSearch)(std::unordered_map<std::string, float>&, SA_policy<T>&) = nullptr;
-    bool (*restart)(std::unordered_map<std::string, float>&, SA_policy<T>&) = nullptr;
+    // objective value of a solution, needed for SA_tempering. Without it the best f of the instrumentation
+    // summaries (SA_INSTRUMENT) is NaN
+    float (*getEnergy)(T&) = nullptr;
+    bool (*endSearch)(C&, SA_policy<T>&) = nullptr;
+    bool (*restart)(C&, SA_policy<T>&) = nullptr;
+    // per-run state of the context (random generator, counters) for snapshots, only needed to resume runs exactly
+    void (*saveState)(C&, SA_snapshotWriter&) = nullptr;
+    void (*loadState)(C&, SA_snapshotReader&) = nullptr;
+    // divides the budgets kept in the context between that many runs sharing them, for SA_tempering
+    void (*shareBudget)(C&, int) = nullptr;
 };
 
-template <typename T>
-class SA
+// adapts a ProblemCtx into a problem policy for SA_engine, every hook goes through the function pointers
+template <typename T, typename C>
+struct ProblemCtxPolicy
 {
-private:
-    T _currSoln;
-    T _bestSoln;
-    std::vector<T> _allAcceptedSolns;
-    std::vector<T> _allSolns;
-    std::vector<float> _annealingSchedule;
-    std::vector<float> _acceptProbs;
-    
-    std::unordered_map<std::string, float> _parameters;
-    ProblemCtx<T> _problemCtx;
-    SA_policy<T> _runtimeInfo;
-    std::mt19937 _randGen;
-public:
-    SA(ProblemCtx<T>& problemCtx, std::unordered_map<std::string, float>& parameters)
+    using soln_type = T;
+    struct context_type
     {
-        _parameters = parameters;
-        _problemCtx = problemCtx;
-        _runtimeInfo = {};
-       _randGen.seed(std::time(NULL));
-       _problemCtx.setRandomGenerator(_randGen);
-    }
+        ProblemCtx<T, C> problemCtx;
+        C ctx;
+    };
 
-    void printAllToFile(const std::string fileName)
-    {   // prints entire optimisation journey to file 
-        // each line is: [solution], temperature, acceptProb
-        std::ofstream outfile;
-        outfile.open(fileName, std::ios::out|std::ios::trunc);
-        for(int i=0; i<_allSolns.size(); i++)
-        {
-            outfile << _allSolns[i] << ", " 
-                    << _annealingSchedule[i] << ", "
-                    << _acceptProbs[i] << '\n';
+    static context_type createContext(ProblemCtx<T, C>& problemCtx, std::unordered_map<std::string, float>& parameters)
+    {
+        if constexpr (std::is_same_v<C, std::unordered_map<std::string, float>>)
+        {   // untyped problems use the parameter map as it is
+            if(problemCtx.createContext == nullptr) return {problemCtx, parameters};
         }
-        outfile.close();
+        return {problemCtx, problemCtx.createContext(parameters)};
     }
 
-    void printAcceptedToFile(const std::string fileName)
-    {   // prints only accepted solutions to file 
-        // each line is: [solution]
-        std::ofstream outfile;
-        outfile.open(fileName, std::ios::out|std::ios::trunc);
-        for(T s : _allAcceptedSolns)
-        {
-            outfile << s << '\n';
-        }
-        outfile.close();
+    static void setRandomGenerator(context_type& c, SA_random& gen){ c.problemCtx.setRandomGenerator(c.ctx, gen); }
+
+    static SA_policy<T> initRuntimeInfo(context_type& c){ return c.problemCtx.initRuntimeInfo(c.ctx); }
+
+    static T getRandomSolution(context_type& c){ return c.problemCtx.getRandomSolution(c.ctx); }
+
+    static T getNewSolution(context_type& c, SA_policy<T>& runtimeInfo, T& currSoln)
+    {
+        return c.problemCtx.getNewSolution(c.ctx, runtimeInfo, currSoln);
     }
 
-    // get the curr soluton and best solution found
-    std::pair<T,T> getOptimisationResult(){ return {_currSoln, _bestSoln}; }
+    static float acceptProbability(context_type& c, SA_policy<T>& runtimeInfo, T& newSoln, T& currSoln)
+    {
+        return c.problemCtx.acceptProbability(c.ctx, runtimeInfo, newSoln, currSoln);
+    }
 
-    // retrieve the runtime information
-    SA_policy<T> getRuntimeInfo(){ return _runtimeInfo; }
+    static void updateRuntimeInfo(context_type& c, SA_policy<T>& runtimeInfo, T& newSoln, T& currSoln, bool accepted)
+    {
+        c.problemCtx.updateRuntimeInfo(c.ctx, runtimeInfo, newSoln, currSoln, accepted);
+    }
+
+    static bool compareSoln(context_type& c, T& betterSoln, T& worseSoln){ return c.problemCtx.compareSoln(betterSoln, worseSoln); }
 
-    void optimise()
+    static float getEnergy(context_type& c, T& soln)
     {
-        // prepare for optimisation
-        _currSoln = _problemCtx.getRandomSolution(_parameters);
-        _runtimeInfo = _problemCtx.initRuntimeInfo(_parameters);
-        _allSolns.clear();
-        _allAcceptedSolns.clear();
-        _annealingSchedule.clear();
-        _acceptProbs.clear();
-        int progressCounter = 0;
-        std::uniform_real_distribution<float> uniformDist{0, 1.0};
-        std::cout << "intial temperature : " << _runtimeInfo.temperature << '\n';
-
-        // do the optimisation
-        while((progressCounter < _parameters["max iterations"]) && (!_problemCtx.endSearch(_parameters, _runtimeInfo)))
-        {
-            // get a new solution
-            T newSoln = _problemCtx.getNewSolution(_parameters, _runtimeInfo, _currSoln);
-
-            // update all the trackers
-            _allSolns.push_back(_currSoln);
-            _annealingSchedule.push_back(_runtimeInfo.temperature);
-            _acceptProbs.push_back(_problemCtx.acceptProbability(_parameters, _runtimeInfo, newSoln, _currSoln));
-
-            // generate a value in (0, 1) for probability acceptance
-            float u = uniformDist(_randGen);
-            if(u < _problemCtx.acceptProbability(_parameters, _runtimeInfo, newSoln, _currSoln))
-            {
-                // update runtimeinfo knowing that new solution is accepted
-                _problemCtx.updateRuntimeInfo(_parameters, _runtimeInfo, newSoln, _currSoln, true);
-
-                // update archive
-                _currSoln = newSoln;
-                _allAcceptedSolns.push_back(newSoln);
-                if(_problemCtx.compareSoln(_currSoln, _bestSoln)) _bestSoln = _currSoln;
-            }else
-            {
-                // update runtimeinfo knowing that new solution is rejected
-                _problemCtx.updateRuntimeInfo(_parameters, _runtimeInfo, newSoln, _currSoln, false);
-                // restart the search if necessary
-                if(_problemCtx.restart(_parameters, _runtimeInfo)) _currSoln = _bestSoln;
-            }
-        }
+        if(c.problemCtx.getEnergy == nullptr) return std::numeric_limits<float>::quiet_NaN();
+        return c.problemCtx.getEnergy(soln);
     }
+
+    static bool endSearch(context_type& c, SA_policy<T>& runtimeInfo){ return c.problemCtx.endSearch(c.ctx, runtimeInfo); }
+
+    static bool restart(context_type& c, SA_policy<T>& runtimeInfo){ return c.problemCtx.restart(c.ctx, runtimeInfo); }
+
+    static void saveState(context_type& c, SA_snapshotWriter& writer)
+    {
+        if(c.problemCtx.saveState != nullptr) c.problemCtx.saveState(c.ctx, writer);
+    }
+
+    static void loadState(context_type& c, SA_snapshotReader& reader)
+    {
+        if(c.problemCtx.loadState != nullptr) c.problemCtx.loadState(c.ctx, reader);
+    }
+
+    static void shareBudget(context_type& c, int numParts)
+    {
+        if(c.problemCtx.shareBudget != nullptr) c.problemCtx.shareBudget(c.ctx, numParts);
+    }
+};
+
+// the original function pointer based interface, kept as an adapter over SA_engine
+// (use SA_engine directly with a problem policy to have the problem methods inlined).
+// It records nothing by default, so the annealing loop pays nothing for it. Give SA_decimatedRecorder<T> as Recorder
+// to keep the trajectory in memory for printAllToFile and printAcceptedToFile
+template <typename T, typename C = std::unordered_map<std::string, float>, typename Recorder = SA_nullRecorder<T>>
+class SA : public SA_engine<ProblemCtxPolicy<T, C>, Recorder>
+{
+public:
+    SA(ProblemCtx<T, C>& problemCtx, std::unordered_map<std::string, float>& parameters)
+        : SA_engine<ProblemCtxPolicy<T, C>, Recorder>(ProblemCtxPolicy<T, C>::createContext(problemCtx, parameters),
+                                                      SA_settings::fromParameters(parameters)) {}
+
+    SA(ProblemCtx<T, C>& problemCtx, std::unordered_map<std::string, float>& parameters, const SA_settings& settings)
+        : SA_engine<ProblemCtxPolicy<T, C>, Recorder>(ProblemCtxPolicy<T, C>::createContext(problemCtx, parameters),
+                                                      settings) {}
+
+    void printAllToFile(const std::string fileName){ this->_recorder.printAllToFile(fileName); }
+
+    void printAcceptedToFile(const std::string fileName){ this->_recorder.printAcceptedToFile(fileName); }
+
+    // the context created by the ProblemCtx
+    C& getContext(){ return this->_ctx.ctx; }
 };
 
-#endif // INCLUDE_SA_CORE
\ No newline at end of file
+#endif // INCLUDE_SA_CORE
@@ -0,0 +1,613 @@
+#ifndef INCLUDE_SA_ENGINE
+#define INCLUDE_SA_ENGINE
+
+#include <random>
+#include <unordered_map>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <ostream>
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include "recorder.hpp"
+#include "instrument.hpp"
+#include "random.hpp"
+#include "checkpoint.hpp"
+#include "workers.hpp"
+
+template <typename T>
+struct SA_policy
+{
+    float temperature;
+    T maxChange; // for creating new solutions
+    int numAcceptedCurrTemp; // number of solutions accepted at current temperature
+    int numCurrTemp; // number of trials at current temperature
+    int numTempSteps; // number of temperature changes
+    int numNoProgress; // number of iterations where no solution is accepted
+};
+
+// whether the problem policy can propose several solutions at once
+template <typename Problem, typename = void>
+struct SA_hasBatchProposals : std::false_type {};
+
+template <typename Problem>
+struct SA_hasBatchProposals<Problem, std::void_t<decltype(Problem::getNewSolutions(
+    std::declval<typename Problem::context_type&>(), std::declval<SA_policy<typename Problem::soln_type>&>(),
+    std::declval<typename Problem::soln_type&>(), std::declval<std::vector<typename Problem::soln_type>&>()))>>
+    : std::true_type {};
+
+// whether the problem policy can draw new solutions and evaluate them separately, so that the evaluations of a
+// step can run in parallel
+template <typename Problem, typename = void>
+struct SA_hasParallelEvaluation : std::false_type {};
+
+template <typename Problem>
+struct SA_hasParallelEvaluation<Problem, std::void_t<decltype(Problem::evaluate(
+    std::declval<typename Problem::context_type&>(), std::declval<std::vector<typename Problem::soln_type>&>(), 0, 0))>>
+    : std::true_type {};
+
+// whether the problem policy proposes moves, changes to the current solution that can be evaluated without
+// evaluating the whole new solution
+template <typename Problem, typename = void>
+struct SA_hasMoves : std::false_type {};
+
+template <typename Problem>
+struct SA_hasMoves<Problem, std::void_t<typename Problem::move_type>> : std::true_type {};
+
+struct SA_noMove {};
+
+template <typename Problem, bool = SA_hasMoves<Problem>::value>
+struct SA_moveType { using type = SA_noMove; };
+
+template <typename Problem>
+struct SA_moveType<Problem, true> { using type = typename Problem::move_type; };
+
+// whether the problem policy does its accepted moves in place on the current solution
+template <typename Problem, typename = void>
+struct SA_hasInPlaceMoves : std::false_type {};
+
+template <typename Problem>
+struct SA_hasInPlaceMoves<Problem, std::void_t<decltype(Problem::doMove(std::declval<typename Problem::context_type&>(),
+    std::declval<typename Problem::move_type&>(), std::declval<typename Problem::soln_type&>()))>>
+    : std::true_type {};
+
+// whether the problem policy gives the energy (objective value) of a solution
+template <typename Problem, typename = void>
+struct SA_hasEnergy : std::false_type {};
+
+template <typename Problem>
+struct SA_hasEnergy<Problem, std::void_t<decltype(Problem::getEnergy(
+    std::declval<typename Problem::context_type&>(), std::declval<typename Problem::soln_type&>()))>>
+    : std::true_type {};
+
+// whether the problem policy can write the per-run state of its context (random stream, counters) into a snapshot
+template <typename Problem, typename = void>
+struct SA_hasSnapshotState : std::false_type {};
+
+template <typename Problem>
+struct SA_hasSnapshotState<Problem, std::void_t<decltype(Problem::saveState(
+    std::declval<typename Problem::context_type&>(), std::declval<SA_snapshotWriter&>()))>>
+    : std::true_type {};
+
+// settings of the annealing loop itself, independent of the problem being solved
+struct SA_settings
+{
+    long maxIterations;
+    uint64_t seed; // seed of the random streams, random (see SA_randomSeed) if not given
+    bool verbose; // print progress to stdout
+    int proposalsPerStep; // solutions proposed (and evaluated together) from the same current solution
+    int speculativeThreads; // threads evaluating the proposals of a step in parallel, the engine's own included
+    bool pinThreads; // pin the speculative workers to cpus, see SA_workerPool
+    double checkpointInterval; // seconds between snapshots written by optimise(), 0 for none
+    std::string checkpointFile;
+    SA_recorderSettings recorder;
+
+    // the values of the parameter map are floats, so a "seed" in it is only exact below 2^24. Callers reading the
+    // parameters from json set seed from the json integer instead (see SA_jsonSeed)
+    static SA_settings fromParameters(std::unordered_map<std::string, float>& parameters)
+    {
+        return {
+            .maxIterations = static_cast<long>(parameters["max iterations"]),
+            .seed = parameters.count("seed") ? static_cast<uint64_t>(parameters["seed"]) : SA_randomSeed(),
+            .verbose = parameters.count("verbose") ? parameters["verbose"] != 0 : true,
+            .proposalsPerStep = parameters.count("proposals per step") ? static_cast<int>(parameters["proposals per step"]) : 1,
+            .speculativeThreads = parameters.count("speculative threads") ? static_cast<int>(parameters["speculative threads"]) : 0,
+            .pinThreads = parameters.count("pin threads") ? parameters["pin threads"] != 0 : false,
+            .checkpointInterval = parameters.count("checkpoint interval") ? parameters["checkpoint interval"] : 0,
+            .checkpointFile = "snapshot.bin",
+            .recorder = SA_recorderSettings::fromParameters(parameters)
+        };
+    }
+};
+
+// SA_engine runs the annealing loop on a problem policy: a type whose problem specific methods are
+// static member functions, so the compiler can inline them into the loop. A problem policy defines
+//   soln_type        the solution type
+//   context_type     the problem parameters, parsed once before the optimisation starts, together with any
+//                    state private to a run (random generator, counters). Each SA_engine owns its own
+//                    context, so independent runs can be done concurrently
+// and the static methods
+//   context_type createContext(std::unordered_map<std::string, float>&)
+//   void setRandomGenerator(context_type&, SA_random&)   hands the problem its own random stream
+//   SA_policy<soln_type> initRuntimeInfo(context_type&)
+//   soln_type getRandomSolution(context_type&)
+//   soln_type getNewSolution(context_type&, SA_policy<soln_type>&, soln_type&)
+//   float acceptProbability(context_type&, SA_policy<soln_type>&, soln_type&, soln_type&)
+//   void updateRuntimeInfo(context_type&, SA_policy<soln_type>&, soln_type&, soln_type&, bool)
+//   bool compareSoln(context_type&, soln_type&, soln_type&)
+//   bool endSearch(context_type&, SA_policy<soln_type>&)
+//   bool restart(context_type&, SA_policy<soln_type>&)
+// which have the same meaning as the function pointers in ProblemCtx (see core.hpp). Optionally it can define
+//   void getNewSolutions(context_type&, SA_policy<soln_type>&, soln_type&, std::vector<soln_type>&)
+// to generate and evaluate several new solutions at once, used when "proposals per step" is more than 1.
+// With "speculative threads" the proposals of a step are evaluated in parallel instead, which needs
+//   void proposeSolution(context_type&, SA_policy<soln_type>&, soln_type&, soln_type&)   draw a new solution from
+//                                                        the curr soln into the last one, without evaluating it
+//   void evaluate(context_type&, std::vector<soln_type>&, int first, int last)   evaluate the solutions in
+//                                                        [first, last), called concurrently on disjoint ranges, must
+//                                                        only read the context
+// proposeSolution must make the same draws as getNewSolutions, and evaluate give the same objective values (the
+// same kernel), so with the proposals drawn one after the other on the engine's thread and tested in order the
+// chain does not depend on the number of threads.
+// It can also propose moves instead of whole new solutions, by defining move_type and
+//   void getNewMove(context_type&, SA_policy<soln_type>&, soln_type&, move_type&)   fill in a move from the curr soln
+//   void deltaEvaluate(context_type&, move_type&, soln_type&)   objective value after the move, stored in the move
+//   void apply(context_type&, move_type&, soln_type&)           change the curr soln in place
+//   float acceptProbability(context_type&, SA_policy<soln_type>&, move_type&, soln_type&)
+//   void updateRuntimeInfo(context_type&, SA_policy<soln_type>&, move_type&, soln_type&, bool)
+// moves are then used for single proposal steps, so a problem whose objective is a sum of independent terms
+// only pays for the terms a move changes.
+// For solutions too large to copy on every iteration (long permutations, grids) the policy can instead do its
+// moves in place, by defining move_type, getNewMove, getEnergy and
+//   float moveDelta(context_type&, move_type&, soln_type&)   change of the energy the move would make, without
+//                                                         changing the curr soln
+//   void doMove(context_type&, move_type&, soln_type&)    change the curr soln, only called for accepted moves
+//   float acceptProbability(context_type&, SA_policy<soln_type>&, move_type&, float energyChange)
+//   void updateRuntimeInfo(context_type&, SA_policy<soln_type>&, move_type&, soln_type&, bool)   after the move
+//                                                         was done or rejected
+// Every step is then a single move, and a rejected move costs only its moveDelta. No solution is copied, except
+// the best one: it is only tracked by its energy while the search stays on it, and copied when an accepted move
+// leaves it, just before the move is done.
+// SA_tempering also needs
+//   float getEnergy(context_type&, soln_type&)
+// and snapshots (see saveSnapshot) need
+//   void saveState(context_type&, SA_snapshotWriter&)   the per-run state of the context
+//   void loadState(context_type&, SA_snapshotReader&)
+// to resume a run exactly, solutions are written with SA_snapshotTraits (see checkpoint.hpp)
+// The trajectory is kept by the Recorder (see recorder.hpp), by default nothing is recorded. Builds with
+// SA_INSTRUMENT also time the phases of the loop and summarise every temperature step (see instrument.hpp)
+template <typename Problem, typename Recorder = SA_nullRecorder<typename Problem::soln_type>>
+class SA_engine
+{
+public:
+    using soln_type = typename Problem::soln_type;
+    using context_type = typename Problem::context_type;
+
+protected:
+    soln_type _currSoln;
+    soln_type _bestSoln;
+    Recorder _recorder;
+    std::vector<soln_type> _proposals; // when several solutions are proposed at each step
+    typename SA_moveType<Problem>::type _move; // reused for every move proposed
+
+    context_type _ctx;
+    SA_settings _settings;
+    SA_policy<soln_type> _runtimeInfo;
+    SA_random _randGen; // stream of the engine, the problem gets a split of it
+    long _numIterations;
+    long _numResumedIterations; // iterations done before the snapshot the run was resumed from
+    SA_instrumentation<soln_type> _instrumentation;
+    std::unique_ptr<SA_workerPool> _workers; // for speculative steps
+
+    // with in-place moves the best solution is copied lazily: while _bestIsCurr the current solution is the best
+    // one and _bestSoln is out of date
+    bool _bestIsCurr;
+    float _bestEnergy;
+
+    static const int checkpointCheckSteps = 1024; // steps between looking at the clock when checkpointing
+    int _stepsSinceCheck;
+    std::chrono::steady_clock::time_point _lastCheckpoint;
+    double _checkpointCost; // seconds the last snapshot took
+
+public:
+    SA_engine(std::unordered_map<std::string, float>& parameters)
+        : SA_engine(Problem::createContext(parameters), SA_settings::fromParameters(parameters)) {}
+
+    SA_engine(const context_type& ctx, const SA_settings& settings)
+        : SA_engine(ctx, settings, SA_random(settings.seed)) {}
+
+    // runs on the given random stream instead of one seeded with settings.seed, for engines sharing a seed
+    SA_engine(const context_type& ctx, const SA_settings& settings, const SA_random& stream)
+        : _recorder(settings.recorder), _ctx(ctx), _settings(settings), _randGen(stream)
+    {
+        setUp();
+    }
+
+    // starts over with a new problem context and settings, for a long lived engine running one job after another.
+    // The solutions, proposals, recorder and workers of the engine are kept, so they do not allocate again (the
+    // recorder keeps the recorder settings it was made with)
+    void reset(const context_type& ctx, const SA_settings& settings)
+    {
+        _ctx = ctx;
+        _settings = settings;
+        _randGen = SA_random(settings.seed);
+        setUp();
+    }
+
+    // the recorder keeping the trajectory of the last optimisation
+    Recorder& getRecorder(){ return _recorder; }
+
+    // get the curr soluton and best solution found
+    std::pair<soln_type, soln_type> getOptimisationResult()
+    {
+        syncBest();
+        return {_currSoln, _bestSoln};
+    }
+
+    // retrieve the runtime information
+    SA_policy<soln_type> getRuntimeInfo(){ return _runtimeInfo; }
+
+    // phase timings, temperature step summaries and restarts of the last optimisation, empty without SA_INSTRUMENT
+    SA_instrumentation<soln_type>& getInstrumentation(){ return _instrumentation; }
+
+    // the settings of the run, with the seed it was given (or drew) to reproduce it
+    const SA_settings& getSettings(){ return _settings; }
+
+    // the parameters and per-run state of the problem
+    context_type& getContext(){ return _ctx; }
+
+    // number of iterations done by the last call to optimise(), after resume() including those before the snapshot
+    long getNumIterations(){ return _numIterations; }
+
+    // number of iterations the last run had done before the snapshot it was resumed from, 0 if it was not resumed
+    long getNumResumedIterations(){ return _numResumedIterations; }
+
+protected:
+    void setUp()
+    {   // gives the problem its random stream and resets the state of the last run
+        _runtimeInfo = {};
+        _numIterations = 0;
+        _numResumedIterations = 0;
+        _bestIsCurr = false;
+        _bestEnergy = 0;
+        _stepsSinceCheck = 0;
+        _checkpointCost = 0;
+        SA_random problemStream = _randGen.split();
+        Problem::setRandomGenerator(_ctx, problemStream);
+        if constexpr (SA_hasParallelEvaluation<Problem>::value)
+        {   // the calling thread evaluates proposals too, so it is one of the threads
+            int numWorkers = (_settings.speculativeThreads > 1 && _settings.proposalsPerStep > 1) ? _settings.speculativeThreads - 1 : 0;
+            if(numWorkers == 0) _workers.reset();
+            else if(_workers == nullptr || _workers->size() != numWorkers || _workers->isPinned() != _settings.pinThreads)
+                _workers = std::make_unique<SA_workerPool>(numWorkers, _settings.pinThreads);
+        }
+    }
+
+    void proposeBatch()
+    {
+        if constexpr (SA_hasParallelEvaluation<Problem>::value)
+        {
+            if(_workers != nullptr)
+            {   // speculative: every proposal is evaluated, on the workers, although most of them get rejected
+                for(soln_type& newSoln : _proposals) Problem::proposeSolution(_ctx, _runtimeInfo, _currSoln, newSoln);
+                _instrumentation.lap(SA_phase::propose);
+                int numThreads = _workers->size() + 1;
+                int rangeSize = (static_cast<int>(_proposals.size()) + numThreads - 1) / numThreads;
+                _workers->run(numThreads, [this, rangeSize](int t)
+                {
+                    int first = t * rangeSize;
+                    int last = std::min(first + rangeSize, static_cast<int>(_proposals.size()));
+                    if(first < last) Problem::evaluate(_ctx, _proposals, first, last);
+                });
+                _instrumentation.lap(SA_phase::evaluate);
+                return;
+            }
+        }
+        if constexpr (SA_hasBatchProposals<Problem>::value)
+            Problem::getNewSolutions(_ctx, _runtimeInfo, _currSoln, _proposals);
+        else
+            for(soln_type& newSoln : _proposals) newSoln = Problem::getNewSolution(_ctx, _runtimeInfo, _currSoln);
+        _instrumentation.lap(SA_phase::propose);
+    }
+
+    template <typename Monitor>
+    void run(Monitor&& monitor)
+    {   // the annealing loop from the current state to the end, or until the monitor stops it
+        _lastCheckpoint = std::chrono::steady_clock::now();
+        while(!isFinished())
+        {
+            step();
+            if(++_stepsSinceCheck >= checkpointCheckSteps)
+            {
+                _stepsSinceCheck = 0;
+                if(_settings.checkpointInterval > 0) checkpoint();
+                if(!monitor()) break;
+            }
+        }
+        syncBest();
+        _recorder.finish();
+        _instrumentation.finish(_runtimeInfo, [this]{ return bestEnergy(); });
+    }
+
+    void syncBest()
+    {   // brings _bestSoln up to date when it is tracked lazily
+        if(_bestIsCurr) _bestSoln = _currSoln;
+        _bestIsCurr = false;
+    }
+
+    void checkBest()
+    {   // after the curr soln was replaced outside of the loop, keep it if it is the best so far
+        if constexpr (SA_hasInPlaceMoves<Problem>::value)
+        {
+            float energy = Problem::getEnergy(_ctx, _currSoln);
+            if(energy < _bestEnergy)
+            {
+                _bestEnergy = energy;
+                _bestIsCurr = true;
+            }
+        }else if(Problem::compareSoln(_ctx, _currSoln, _bestSoln)) _bestSoln = _currSoln;
+    }
+
+    void checkpoint()
+    {   // writes a snapshot once the interval has passed since the last one. The interval is stretched to 100 times
+        // what the last snapshot took, so writing them never costs more than 1% of the run
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        double elapsed = std::chrono::duration<double>(now - _lastCheckpoint).count();
+        if(elapsed < std::max(_settings.checkpointInterval, 100 * _checkpointCost)) return;
+        saveSnapshot(_settings.checkpointFile);
+        _lastCheckpoint = std::chrono::steady_clock::now();
+        _checkpointCost = std::chrono::duration<double>(_lastCheckpoint - now).count();
+    }
+
+    float bestEnergy()
+    {   // for the instrumentation, NaN if the problem policy has no getEnergy
+        if constexpr (SA_hasInPlaceMoves<Problem>::value) return _bestEnergy;
+        else if constexpr (SA_hasEnergy<Problem>::value) return Problem::getEnergy(_ctx, _bestSoln);
+        else return std::numeric_limits<float>::quiet_NaN();
+    }
+
+    template <typename Proposal>
+    bool testProposal(Proposal& proposal)
+    {   // one iteration: Metropolis test of a solution (or a move) proposed from the current solution,
+        // returns true if the current solution changed
+        float acceptProb = Problem::acceptProbability(_ctx, _runtimeInfo, proposal, _currSoln);
+
+        // update the trajectory
+        _recorder.recordStep(_numIterations, _currSoln, _runtimeInfo.temperature, acceptProb);
+
+        // generate a value in (0, 1) for probability acceptance
+        float u = _randGen.uniform();
+        _instrumentation.lap(SA_phase::acceptTest);
+        bool changed = false;
+        bool accepted = u < acceptProb;
+        if(accepted)
+        {
+            // update runtimeinfo knowing that new solution is accepted
+            Problem::updateRuntimeInfo(_ctx, _runtimeInfo, proposal, _currSoln, true);
+
+            // update archive
+            if constexpr (std::is_same_v<Proposal, soln_type>) _currSoln = proposal;
+            else Problem::apply(_ctx, proposal, _currSoln);
+            _recorder.recordAccepted(_numIterations, _currSoln);
+            if(Problem::compareSoln(_ctx, _currSoln, _bestSoln)) _bestSoln = _currSoln;
+            changed = true;
+            _instrumentation.lap(SA_phase::update);
+        }else
+        {
+            // update runtimeinfo knowing that new solution is rejected
+            Problem::updateRuntimeInfo(_ctx, _runtimeInfo, proposal, _currSoln, false);
+            _instrumentation.lap(SA_phase::update);
+            // restart the search if necessary
+            if(Problem::restart(_ctx, _runtimeInfo))
+            {
+                _currSoln = _bestSoln;
+                changed = true;
+                _instrumentation.restart(_numIterations, _runtimeInfo, [this]{ return bestEnergy(); });
+            }
+            _instrumentation.lap(SA_phase::restart);
+        }
+        _instrumentation.trial(accepted, _runtimeInfo, [this]{ return bestEnergy(); });
+        _numIterations += 1;
+        return changed;
+    }
+
+    void stepInPlace()
+    {   // one iteration of an in-place policy: the change of energy is computed first and the move is only done on
+        // the curr soln if it is accepted
+        Problem::getNewMove(_ctx, _runtimeInfo, _currSoln, _move);
+        _instrumentation.lap(SA_phase::propose);
+        float energyChange = Problem::moveDelta(_ctx, _move, _currSoln);
+        _instrumentation.lap(SA_phase::evaluate);
+        float acceptProb = Problem::acceptProbability(_ctx, _runtimeInfo, _move, energyChange);
+        _recorder.recordStep(_numIterations, _currSoln, _runtimeInfo.temperature, acceptProb);
+        float u = _randGen.uniform();
+        _instrumentation.lap(SA_phase::acceptTest);
+        bool accepted = u < acceptProb;
+        if(accepted)
+        {
+            if(_bestIsCurr && energyChange > 0)
+            {   // the search leaves the best solution, which is only now copied
+                _bestSoln = _currSoln;
+                _bestIsCurr = false;
+            }
+            Problem::doMove(_ctx, _move, _currSoln);
+            float energy = Problem::getEnergy(_ctx, _currSoln);
+            if(energy < _bestEnergy)
+            {
+                _bestEnergy = energy;
+                _bestIsCurr = true;
+            }
+            Problem::updateRuntimeInfo(_ctx, _runtimeInfo, _move, _currSoln, true);
+            _recorder.recordAccepted(_numIterations, _currSoln);
+            _instrumentation.lap(SA_phase::update);
+        }else
+        {
+            Problem::updateRuntimeInfo(_ctx, _runtimeInfo, _move, _currSoln, false);
+            _instrumentation.lap(SA_phase::update);
+            if(Problem::restart(_ctx, _runtimeInfo))
+            {
+                if(!_bestIsCurr) _currSoln = _bestSoln;
+                _bestIsCurr = true;
+                _instrumentation.restart(_numIterations, _runtimeInfo, [this]{ return bestEnergy(); });
+            }
+            _instrumentation.lap(SA_phase::restart);
+        }
+        _instrumentation.trial(accepted, _runtimeInfo, [this]{ return bestEnergy(); });
+        _numIterations += 1;
+    }
+
+    void assignProposals()
+    {   // in-place policies never propose whole solutions
+        if constexpr (!SA_hasInPlaceMoves<Problem>::value)
+            _proposals.assign(std::max(_settings.proposalsPerStep, 1), _currSoln);
+    }
+
+public:
+    void initialise(){ initialiseWith(nullptr); }
+
+    // as initialise, but starting from the given runtime info instead of the problem's initRuntimeInfo, for
+    // engines sharing a single initial search (like the chains of SA_tempering)
+    void initialise(const SA_policy<soln_type>& runtimeInfo){ initialiseWith(&runtimeInfo); }
+
+protected:
+    void initialiseWith(const SA_policy<soln_type>* runtimeInfo)
+    {   // prepare for optimisation
+        _instrumentation.start();
+        _currSoln = Problem::getRandomSolution(_ctx);
+        _bestSoln = _currSoln;
+        if constexpr (SA_hasInPlaceMoves<Problem>::value) _bestEnergy = Problem::getEnergy(_ctx, _currSoln);
+        _bestIsCurr = false;
+        _runtimeInfo = runtimeInfo != nullptr ? *runtimeInfo : Problem::initRuntimeInfo(_ctx);
+        _recorder.start(_currSoln);
+        assignProposals();
+        _numIterations = 0;
+        _numResumedIterations = 0;
+        _stepsSinceCheck = 0;
+        _instrumentation.beginTemperatureStep(_runtimeInfo);
+        _instrumentation.lap(SA_phase::initialise);
+        if(_settings.verbose) std::cout << "intial temperature : " << _runtimeInfo.temperature << '\n';
+    }
+
+public:
+
+    bool isFinished()
+    {
+        return (_numIterations >= _settings.maxIterations) || Problem::endSearch(_ctx, _runtimeInfo);
+    }
+
+    void step()
+    {   // do a single step of the annealing loop
+        _instrumentation.mark();
+        if constexpr (SA_hasInPlaceMoves<Problem>::value)
+        {   // always a single move, "proposals per step" does not apply
+            stepInPlace();
+        }else if(_settings.proposalsPerStep <= 1)
+        {
+            if constexpr (SA_hasMoves<Problem>::value)
+            {
+                Problem::getNewMove(_ctx, _runtimeInfo, _currSoln, _move);
+                _instrumentation.lap(SA_phase::propose);
+                Problem::deltaEvaluate(_ctx, _move, _currSoln);
+                _instrumentation.lap(SA_phase::evaluate);
+                testProposal(_move);
+            }else
+            {
+                soln_type newSoln = Problem::getNewSolution(_ctx, _runtimeInfo, _currSoln);
+                _instrumentation.lap(SA_phase::propose);
+                testProposal(newSoln);
+            }
+        }else
+        {   // generate several proposals from the current solution at once, and test them in order until the current
+            // solution changes. maxChange is only updated when a solution is accepted, so the proposals are drawn
+            // from the same distribution as when testing them one at a time (proposals left after a change are
+            // evaluated but discarded). It is not the same chain: the discarded proposals use up random draws, and
+            // getNewSolutions may score differently from getNewSolution (Schwefel's vector kernels differ in the
+            // last bits, so its chain depends on the kernel the cpu selects)
+            proposeBatch();
+            for(soln_type& newSoln : _proposals)
+                if(testProposal(newSoln) || isFinished()) break;
+        }
+    }
+
+    void optimise()
+    {
+        initialise();
+        run([]{ return true; });
+    }
+
+    // the same, calling monitor() every few thousand iterations (to report progress, or bound the time of the run)
+    // and stopping early when it returns false
+    template <typename Monitor>
+    void optimise(Monitor&& monitor)
+    {
+        initialise();
+        run(monitor);
+    }
+
+    // writes the state of the run between two steps to fileName: the current and best solutions, runtime info,
+    // iteration count, the random streams of the engine and problem, the per-run state of the context and where
+    // the recorder is. The file is replaced atomically, so it always holds a complete snapshot
+    void saveSnapshot(const std::string& fileName)
+    {
+        syncBest();
+        SA_snapshotWriter writer;
+        writer.write(_settings.seed);
+        writer.write(_numIterations);
+        SA_snapshotTraits<soln_type>::save(writer, _currSoln);
+        SA_snapshotTraits<soln_type>::save(writer, _bestSoln);
+        writer.write(_runtimeInfo.temperature);
+        SA_snapshotTraits<soln_type>::save(writer, _runtimeInfo.maxChange);
+        writer.write(_runtimeInfo.numAcceptedCurrTemp);
+        writer.write(_runtimeInfo.numCurrTemp);
+        writer.write(_runtimeInfo.numTempSteps);
+        writer.write(_runtimeInfo.numNoProgress);
+        writer.write(_randGen);
+        if constexpr (SA_hasSnapshotState<Problem>::value) Problem::saveState(_ctx, writer);
+        _recorder.saveState(writer);
+        writer.commit(fileName);
+    }
+
+    // restores the state written by saveSnapshot, into an engine made with the same parameters
+    void loadSnapshot(const std::string& fileName)
+    {
+        SA_snapshotReader reader(fileName);
+        reader.read(_settings.seed);
+        reader.read(_numIterations);
+        _numResumedIterations = _numIterations;
+        SA_snapshotTraits<soln_type>::load(reader, _currSoln);
+        SA_snapshotTraits<soln_type>::load(reader, _bestSoln);
+        reader.read(_runtimeInfo.temperature);
+        SA_snapshotTraits<soln_type>::load(reader, _runtimeInfo.maxChange);
+        reader.read(_runtimeInfo.numAcceptedCurrTemp);
+        reader.read(_runtimeInfo.numCurrTemp);
+        reader.read(_runtimeInfo.numTempSteps);
+        reader.read(_runtimeInfo.numNoProgress);
+        reader.read(_randGen);
+        if constexpr (SA_hasSnapshotState<Problem>::value) Problem::loadState(_ctx, reader);
+        _recorder.loadState(reader);
+        _bestIsCurr = false;
+        if constexpr (SA_hasInPlaceMoves<Problem>::value) _bestEnergy = Problem::getEnergy(_ctx, _bestSoln);
+    }
+
+    // continues the run saved in a snapshot to the end, as optimise() would have continued it.
+    // The instrumentation only covers the resumed part
+    void resume(const std::string& fileName)
+    {
+        _instrumentation.start();
+        loadSnapshot(fileName);
+        assignProposals();
+        _stepsSinceCheck = 0;
+        _instrumentation.beginTemperatureStep(_runtimeInfo);
+        _instrumentation.lap(SA_phase::initialise);
+        run([]{ return true; });
+    }
+
+    template <typename> friend class SA_tempering;
+};
+
+#endif // INCLUDE_SA_ENGINE
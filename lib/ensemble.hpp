@@ -0,0 +1,146 @@
+#ifndef INCLUDE_SA_ENSEMBLE
+#define INCLUDE_SA_ENSEMBLE
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <vector>
+#include "engine.hpp"
+#include "thread_pool.hpp"
+
+// outcome of a single run of an ensemble
+struct SA_runResult
+{
+    uint64_t seed;
+    float currEval; // objective value of the final solution
+    float bestEval; // objective value of the best solution found
+    long numIterations;
+    double runtime; // in ms
+    bool success; // whether the run found the known optimum
+};
+
+struct SA_histogram
+{
+    float lower; // lower edge of the first bin
+    float upper; // upper edge of the last bin
+    std::vector<int> counts;
+
+    static SA_histogram fromValues(const std::vector<float>& values, int numBins)
+    {
+        SA_histogram h{0, 0, std::vector<int>(numBins, 0)};
+        if(values.empty()) return h;
+        h.lower = *std::min_element(values.begin(), values.end());
+        h.upper = *std::max_element(values.begin(), values.end());
+        float width = (h.upper - h.lower) / numBins;
+        for(float v : values)
+        {
+            int bin = width > 0 ? static_cast<int>((v - h.lower) / width) : 0;
+            h.counts[std::min(bin, numBins - 1)] += 1;
+        }
+        return h;
+    }
+};
+
+// aggregated statistics over all the runs of an ensemble
+struct SA_ensembleSummary
+{
+    int numRuns;
+    float successRate;
+    SA_histogram bestEval;
+    SA_histogram currEval;
+    double runtimeMean; // in ms
+    double runtimeP50;
+    double runtimeP90;
+    double runtimeP99;
+    double runtimeMax;
+
+    static SA_ensembleSummary fromResults(const std::vector<SA_runResult>& results, int numBins)
+    {
+        SA_ensembleSummary summary{};
+        summary.numRuns = results.size();
+        if(results.empty()) return summary;
+        std::vector<float> bestEvals, currEvals;
+        std::vector<double> runtimes;
+        int numSuccess = 0;
+        for(const SA_runResult& r : results)
+        {
+            bestEvals.push_back(r.bestEval);
+            currEvals.push_back(r.currEval);
+            runtimes.push_back(r.runtime);
+            numSuccess += r.success;
+        }
+        summary.successRate = static_cast<float>(numSuccess) / results.size();
+        summary.bestEval = SA_histogram::fromValues(bestEvals, numBins);
+        summary.currEval = SA_histogram::fromValues(currEvals, numBins);
+
+        std::sort(runtimes.begin(), runtimes.end());
+        auto percentile = [&runtimes](double p){ return runtimes[std::lround(p * (runtimes.size() - 1))]; };
+        for(double t : runtimes) summary.runtimeMean += t / runtimes.size();
+        summary.runtimeP50 = percentile(0.5);
+        summary.runtimeP90 = percentile(0.9);
+        summary.runtimeP99 = percentile(0.99);
+        summary.runtimeMax = runtimes.back();
+        return summary;
+    }
+};
+
+// runs many independent optimisations of the same problem in one process, spread over a thread pool.
+// Every run gets its own SA_engine (and so its own copy of the context), so the problem methods must not
+// share any mutable state between runs
+template <typename Problem>
+class SA_ensemble
+{
+public:
+    using engine_type = SA_engine<Problem>;
+    using context_type = typename Problem::context_type;
+
+private:
+    context_type _ctx;
+    SA_settings _settings;
+    ThreadPool _pool;
+
+public:
+    SA_ensemble(const context_type& ctx, const SA_settings& settings,
+                int numThreads = std::thread::hardware_concurrency())
+        : _ctx(ctx), _settings(settings), _pool(numThreads)
+    {
+        _settings.verbose = false;
+        _settings.checkpointInterval = 0; // the runs would all write the same snapshot
+        _settings.speculativeThreads = 0; // the runs already keep the threads busy
+    }
+
+    int numThreads(){ return _pool.size(); }
+
+    // do numRuns runs, run i is seeded with the settings seed + i.
+    // isSuccess is called on every finished run to decide if it found the known optimum
+    std::vector<SA_runResult> run(int numRuns, std::function<bool(engine_type&)> isSuccess)
+    {
+        std::vector<SA_runResult> results(numRuns);
+        for(int i=0; i<numRuns; i++)
+        {
+            _pool.submit([this, i, &results, &isSuccess]()
+            {
+                SA_settings settings = _settings;
+                settings.seed += i;
+                engine_type SAinst(_ctx, settings);
+                auto start = std::chrono::steady_clock::now();
+                SAinst.optimise();
+                auto finish = std::chrono::steady_clock::now();
+                results[i] = {
+                    .seed = settings.seed,
+                    .currEval = SAinst.getOptimisationResult().first.getEval(),
+                    .bestEval = SAinst.getOptimisationResult().second.getEval(),
+                    .numIterations = SAinst.getNumIterations(),
+                    .runtime = std::chrono::duration<double, std::milli>(finish - start).count(),
+                    .success = isSuccess(SAinst)
+                };
+            });
+        }
+        _pool.wait();
+        return results;
+    }
+};
+
+#endif // INCLUDE_SA_ENSEMBLE
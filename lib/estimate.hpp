@@ -0,0 +1,146 @@
+#ifndef INCLUDE_SA_ESTIMATE
+#define INCLUDE_SA_ESTIMATE
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#define SA_HAS_FLOCK
+#endif
+
+// helpers for estimating the initial temperature from a sample of random solutions
+
+// running mean and variance (Welford), in double so large objective values do not cancel out. Partial results of
+// separate parts of a sample are combined with merge (Chan et al.), which gives the same result whatever the
+// order the parts were computed in, as long as they are merged in the same order
+struct SA_welford
+{
+    long count = 0;
+    double mean = 0;
+    double m2 = 0; // sum of the squared differences from the mean
+
+    void add(double value)
+    {
+        count += 1;
+        double delta = value - mean;
+        mean += delta / count;
+        m2 += delta * (value - mean);
+    }
+
+    void merge(const SA_welford& other)
+    {
+        if(other.count == 0) return;
+        long total = count + other.count;
+        double delta = other.mean - mean;
+        mean += delta * other.count / total;
+        m2 += other.m2 + delta * delta * count * other.count / total;
+        count = total;
+    }
+
+    // of the population, as the E[f^2] - E[f]^2 it replaces
+    double variance(){ return count > 0 ? m2 / count : 0; }
+
+    double stdDev(){ return std::sqrt(variance()); }
+};
+
+// initial temperatures estimated before, kept in a text file with a line "key temperature" per estimate. The key
+// names the problem and everything the estimate depends on (eg. "schwefel 6 -500 500"). A store reads the file,
+// replaces its key and writes it whole to a temporary file of its own that is renamed into place, so a reader never
+// sees it half written. Stores are serialised by a mutex within the process and, where there is flock, by a lock
+// on fileName.lock across processes, so concurrent stores do not lose each other's entries
+class SA_temperatureCache
+{
+private:
+    std::string _fileName;
+
+    static std::mutex& fileMutex()
+    {   // runs in the same process share the file
+        static std::mutex mtx;
+        return mtx;
+    }
+
+    // holds the lock on fileName.lock while it lives, a lock file because the cache file itself is replaced
+    class processLock
+    {
+    private:
+        int _fd = -1;
+
+    public:
+        processLock(const std::string& fileName)
+        {
+#ifdef SA_HAS_FLOCK
+            _fd = open((fileName + ".lock").c_str(), O_RDWR | O_CREAT, 0644);
+            if(_fd >= 0) flock(_fd, LOCK_EX);
+#endif
+        }
+
+        ~processLock()
+        {
+#ifdef SA_HAS_FLOCK
+            if(_fd >= 0) close(_fd); // releases the lock
+#endif
+        }
+
+        processLock(const processLock&) = delete;
+        processLock& operator=(const processLock&) = delete;
+    };
+
+    std::string tmpName()
+    {   // unique to the writer, so that concurrent writers never write the same temporary file
+        std::ostringstream name;
+        name << _fileName << '.';
+#ifdef SA_HAS_FLOCK
+        name << getpid() << '.';
+#endif
+        name << std::hex << std::random_device{}() << ".tmp";
+        return name.str();
+    }
+
+public:
+    SA_temperatureCache(const std::string& fileName = "temperature_cache.txt") : _fileName(fileName) {}
+
+    bool find(const std::string& key, float& temperature)
+    {
+        std::lock_guard<std::mutex> lock(fileMutex());
+        std::ifstream infile(_fileName);
+        std::string line;
+        while(std::getline(infile, line))
+        {
+            size_t split = line.rfind(' ');
+            if(split == std::string::npos || line.compare(0, split, key) != 0 || split != key.size()) continue;
+            std::istringstream(line.substr(split + 1)) >> temperature;
+            return true;
+        }
+        return false;
+    }
+
+    void store(const std::string& key, float temperature)
+    {
+        std::lock_guard<std::mutex> lock(fileMutex());
+        processLock fileLock(_fileName);
+        std::string tmpName = this->tmpName();
+        bool ok;
+        {
+            std::ifstream infile(_fileName);
+            std::ofstream outfile(tmpName, std::ios::out|std::ios::trunc);
+            std::string line;
+            while(std::getline(infile, line))
+                if(line.compare(0, key.size() + 1, key + ' ') != 0) outfile << line << '\n';
+            outfile.precision(9);
+            outfile << key << ' ' << temperature << '\n';
+            outfile.flush();
+            ok = outfile.good();
+        }
+        if(!ok || std::rename(tmpName.c_str(), _fileName.c_str()) != 0) std::remove(tmpName.c_str()); // the cache is only an optimisation
+    }
+};
+
+#endif // INCLUDE_SA_ESTIMATE
@@ -0,0 +1,243 @@
+#ifndef INCLUDE_SA_INSTRUMENT
+#define INCLUDE_SA_INSTRUMENT
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define SA_TSC_TICKS
+#endif
+
+// Instrumentation of the annealing loop, compiled in when SA_INSTRUMENT is defined (cmake -DSA_INSTRUMENT=ON).
+// SA_engine then keeps
+//   the time spent in each phase of the loop, in cpu timestamp counter ticks (ns where there is none) converted
+//   to ns at the end of the optimisation. Proposing includes evaluating the new solution unless the problem
+//   proposes moves, whose evaluation is the evaluate phase
+//   a summary of every temperature step: trials, acceptances, best objective value and mean maxChange
+//   every restart of the search
+// Without SA_INSTRUMENT every method below is empty and the timestamps are never read.
+// The best objective value needs getEnergy in the problem policy, it is null in the json otherwise.
+
+#ifdef SA_INSTRUMENT
+const bool SA_instrumentEnabled = true;
+#else
+const bool SA_instrumentEnabled = false;
+#endif
+
+enum class SA_phase { initialise, propose, evaluate, acceptTest, update, restart };
+
+const int SA_numPhases = 6;
+
+inline const char* SA_phaseName(int phase)
+{
+    static const char* names[SA_numPhases] = {"initialise", "propose", "evaluate", "accept test", "update", "restart"};
+    return names[phase];
+}
+
+// the mean of maxChange over the coordinates. Specialise this for solution types without size() and getX()
+template <typename T>
+struct SA_instrumentTraits
+{
+    static float meanMaxChange(T& maxChange)
+    {
+        float sum = 0;
+        for(int i=0; i<maxChange.size(); i++) sum += maxChange.getX(i);
+        return maxChange.size() > 0 ? sum / maxChange.size() : 0;
+    }
+};
+
+struct SA_temperatureStepSummary
+{
+    int temperatureStep;
+    float temperature;
+    long numTrials;
+    long numAccepted;
+    float bestEval; // objective value of the best solution at the end of the step
+    float meanMaxChange; // at the end of the step
+};
+
+struct SA_restartEvent
+{
+    long iteration;
+    int temperatureStep;
+    float temperature;
+    float bestEval; // objective value of the solution the search restarts from
+};
+
+inline uint64_t SA_ticks()
+{
+#ifdef SA_TSC_TICKS
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+#ifdef SA_INSTRUMENT
+template <typename T>
+class SA_instrumentation
+{
+private:
+    uint64_t _phaseTicks[SA_numPhases];
+    uint64_t _lastTick;
+    uint64_t _startTick;
+    uint64_t _totalTicks;
+    std::chrono::steady_clock::time_point _startTime;
+    double _nsPerTick;
+    SA_temperatureStepSummary _current;
+    std::vector<SA_temperatureStepSummary> _temperatureSteps;
+    std::vector<SA_restartEvent> _restarts;
+
+public:
+    SA_instrumentation() { start(); }
+
+    void start()
+    {   // called before the initial search
+        for(uint64_t& t : _phaseTicks) t = 0;
+        _temperatureSteps.clear();
+        _restarts.clear();
+        _current = {};
+        _totalTicks = 0;
+        _nsPerTick = 0;
+        _startTime = std::chrono::steady_clock::now();
+        _startTick = SA_ticks();
+        _lastTick = _startTick;
+    }
+
+    // start timing from now, what happened since the last lap is not counted in any phase
+    void mark(){ _lastTick = SA_ticks(); }
+
+    // the time since the last lap (or mark) was spent in phase
+    void lap(SA_phase phase)
+    {
+        uint64_t now = SA_ticks();
+        _phaseTicks[static_cast<int>(phase)] += now - _lastTick;
+        _lastTick = now;
+    }
+
+    template <typename RuntimeInfo>
+    void beginTemperatureStep(const RuntimeInfo& runtimeInfo)
+    {
+        _current = {runtimeInfo.numTempSteps, runtimeInfo.temperature, 0, 0, 0, 0};
+    }
+
+    template <typename RuntimeInfo, typename BestEval>
+    void trial(bool accepted, RuntimeInfo& runtimeInfo, BestEval&& bestEval)
+    {   // after the runtime info of a trial is updated, closes the temperature step if the temperature changed
+        _current.numTrials += 1;
+        _current.numAccepted += accepted;
+        if(runtimeInfo.numTempSteps != _current.temperatureStep)
+        {
+            endTemperatureStep(runtimeInfo, bestEval());
+            beginTemperatureStep(runtimeInfo);
+        }
+    }
+
+    template <typename RuntimeInfo, typename BestEval>
+    void restart(long iteration, RuntimeInfo& runtimeInfo, BestEval&& bestEval)
+    {
+        _restarts.push_back({iteration, runtimeInfo.numTempSteps, runtimeInfo.temperature, bestEval()});
+    }
+
+    template <typename RuntimeInfo, typename BestEval>
+    void finish(RuntimeInfo& runtimeInfo, BestEval&& bestEval)
+    {   // called after the last iteration, closes the last temperature step
+        if(_current.numTrials > 0) endTemperatureStep(runtimeInfo, bestEval());
+        _totalTicks = SA_ticks() - _startTick;
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - _startTime).count();
+        _nsPerTick = _totalTicks > 0 ? ns / _totalTicks : 0;
+    }
+
+    uint64_t getPhaseTicks(SA_phase phase){ return _phaseTicks[static_cast<int>(phase)]; }
+
+    // only known after finish()
+    double getPhaseNs(SA_phase phase){ return getPhaseTicks(phase) * _nsPerTick; }
+
+    double getTotalNs(){ return _totalTicks * _nsPerTick; }
+
+    const std::vector<SA_temperatureStepSummary>& getTemperatureSteps(){ return _temperatureSteps; }
+
+    const std::vector<SA_restartEvent>& getRestarts(){ return _restarts; }
+
+    void writeJson(std::ostream& out)
+    {
+        out << "{\n    \"enabled\": true,\n    \"total ns\": " << getTotalNs() << ",\n    \"ns per tick\": " << _nsPerTick
+            << ",\n    \"phases\": {";
+        for(int p=0; p<SA_numPhases; p++)
+            out << (p > 0 ? "," : "") << "\n        \"" << SA_phaseName(p) << "\": {\"ticks\": " << _phaseTicks[p]
+                << ", \"ns\": " << _phaseTicks[p] * _nsPerTick << "}";
+        out << "\n    },\n    \"temperature steps\": [";
+        for(int i=0; i<_temperatureSteps.size(); i++)
+        {
+            SA_temperatureStepSummary& s = _temperatureSteps[i];
+            out << (i > 0 ? "," : "") << "\n        {\"step\": " << s.temperatureStep << ", \"temperature\": "
+                << s.temperature << ", \"trials\": " << s.numTrials << ", \"accepted\": " << s.numAccepted
+                << ", \"best f\": " << jsonNumber(s.bestEval) << ", \"mean max change\": " << jsonNumber(s.meanMaxChange) << "}";
+        }
+        out << "\n    ],\n    \"restarts\": [";
+        for(int i=0; i<_restarts.size(); i++)
+        {
+            SA_restartEvent& r = _restarts[i];
+            out << (i > 0 ? "," : "") << "\n        {\"iteration\": " << r.iteration << ", \"temperature step\": "
+                << r.temperatureStep << ", \"temperature\": " << r.temperature << ", \"best f\": " << jsonNumber(r.bestEval) << "}";
+        }
+        out << "\n    ]\n}\n";
+    }
+
+    void writeJson(const std::string fileName)
+    {
+        std::ofstream outfile(fileName, std::ios::out|std::ios::trunc);
+        writeJson(outfile);
+    }
+
+private:
+    static std::string jsonNumber(float value)
+    {
+        if(!std::isfinite(value)) return "null";
+        std::ostringstream ss;
+        ss << value;
+        return ss.str();
+    }
+
+    template <typename RuntimeInfo>
+    void endTemperatureStep(RuntimeInfo& runtimeInfo, float bestEval)
+    {
+        _current.bestEval = bestEval;
+        _current.meanMaxChange = SA_instrumentTraits<T>::meanMaxChange(runtimeInfo.maxChange);
+        _temperatureSteps.push_back(_current);
+    }
+};
+#else
+template <typename T>
+class SA_instrumentation
+{
+public:
+    void start() {}
+    void mark() {}
+    void lap(SA_phase phase) {}
+    template <typename RuntimeInfo>
+    void beginTemperatureStep(const RuntimeInfo& runtimeInfo) {}
+    template <typename RuntimeInfo, typename BestEval>
+    void trial(bool accepted, RuntimeInfo& runtimeInfo, BestEval&& bestEval) {}
+    template <typename RuntimeInfo, typename BestEval>
+    void restart(long iteration, RuntimeInfo& runtimeInfo, BestEval&& bestEval) {}
+    template <typename RuntimeInfo, typename BestEval>
+    void finish(RuntimeInfo& runtimeInfo, BestEval&& bestEval) {}
+    void writeJson(std::ostream& out){ out << "{\n    \"enabled\": false\n}\n"; }
+    void writeJson(const std::string fileName)
+    {
+        std::ofstream outfile(fileName, std::ios::out|std::ios::trunc);
+        writeJson(outfile);
+    }
+};
+#endif // SA_INSTRUMENT
+
+#endif // INCLUDE_SA_INSTRUMENT
@@ -0,0 +1,15 @@
+#ifndef INCLUDE_SA_JSON
+#define INCLUDE_SA_JSON
+
+#include <cstdint>
+#include "engine.hpp"
+#include "../third_party/nlohmann/json.hpp"
+
+// sets settings.seed from the "seed" of a json parameter file, if it has one. The seed is read as the integer it
+// was written as, as the float parameter map rounds seeds above 2^24 and the run could not be redone from it
+inline void SA_jsonSeed(const nlohmann::json& data, SA_settings& settings)
+{
+    if(data.contains("seed")) settings.seed = data["seed"].get<uint64_t>();
+}
+
+#endif // INCLUDE_SA_JSON
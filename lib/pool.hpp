@@ -0,0 +1,46 @@
+#ifndef INCLUDE_SA_POOL
+#define INCLUDE_SA_POOL
+
+#include <vector>
+
+// thread local free lists of float blocks, one list per block size. Memory is only allocated when the list of the
+// calling thread is empty, so objects that are created and destroyed over and over (like the new solution made at
+// every iteration) keep reusing the same blocks. A block can be released by another thread than the one that
+// acquired it, it then moves to the free list of that thread
+class SA_blockPool
+{
+private:
+    std::vector<std::vector<float*>> _freeBlocks; // indexed by block size
+
+public:
+    ~SA_blockPool()
+    {
+        for(std::vector<float*>& blocks : _freeBlocks)
+            for(float* block : blocks) delete[] block;
+    }
+
+    static SA_blockPool& local()
+    {
+        static thread_local SA_blockPool pool;
+        return pool;
+    }
+
+    float* acquire(int size)
+    {
+        if(size < _freeBlocks.size() && !_freeBlocks[size].empty())
+        {
+            float* block = _freeBlocks[size].back();
+            _freeBlocks[size].pop_back();
+            return block;
+        }
+        return new float[size];
+    }
+
+    void release(float* block, int size)
+    {
+        if(size >= _freeBlocks.size()) _freeBlocks.resize(size + 1);
+        _freeBlocks[size].push_back(block);
+    }
+};
+
+#endif // INCLUDE_SA_POOL
@@ -0,0 +1,201 @@
+#ifndef INCLUDE_SA_RACING
+#define INCLUDE_SA_RACING
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "estimate.hpp"
+#include "random.hpp"
+#include "thread_pool.hpp"
+
+// range a parameter is tuned over, sampled uniformly or uniformly in its logarithm (for scales like alpha)
+struct SA_parameterRange
+{
+    std::string name;
+    float lower;
+    float upper;
+    bool logScale;
+    bool integer; // rounded to the nearest integer, for counts like the chain lengths
+
+    float sample(SA_random& gen)
+    {
+        float value = logScale ? std::exp(gen.uniform(std::log(lower), std::log(upper))) : gen.uniform(lower, upper);
+        return integer ? std::round(value) : value;
+    }
+};
+
+struct SA_racingSettings
+{
+    int numConfigurations; // sampled at random from the ranges, the base parameters are raced as well
+    int numRounds;
+    int eta; // at most 1 / eta of the configurations go on to the next round, whose budget is eta times larger
+    int initialSeeds; // runs of every configuration in the first round, doubled every round
+    int numThreads;
+    uint64_t seed; // of the configuration sampling
+    uint64_t runSeed; // run k of a round is seeded with runSeed + k, so the runs do not change with the sampling
+
+    static SA_racingSettings fromParameters(std::unordered_map<std::string, float>& parameters)
+    {
+        return {
+            .numConfigurations = parameters.count("configurations") ? static_cast<int>(parameters["configurations"]) : 27,
+            .numRounds = parameters.count("rounds") ? static_cast<int>(parameters["rounds"]) : 3,
+            .eta = parameters.count("eta") ? static_cast<int>(parameters["eta"]) : 3,
+            .initialSeeds = parameters.count("seeds") ? static_cast<int>(parameters["seeds"]) : 4,
+            .numThreads = parameters.count("threads") && parameters["threads"] > 0 ? static_cast<int>(parameters["threads"])
+                                                                                   : static_cast<int>(std::thread::hardware_concurrency()),
+            .seed = parameters.count("seed") ? static_cast<uint64_t>(parameters["seed"]) : 0,
+            .runSeed = parameters.count("run seed") ? static_cast<uint64_t>(parameters["run seed"]) : 0
+        };
+    }
+};
+
+// outcome of a single run of a configuration
+struct SA_raceRun
+{
+    float bestEval;
+    double runtime; // in ms
+    double timeToTarget; // in ms, negative if the run did not reach the target
+};
+
+struct SA_candidate
+{
+    int id; // 0 for the base parameters
+    std::unordered_map<std::string, float> parameters;
+    int roundsRun = 0;
+    bool droppedByTest = false; // dropped because it was significantly worse than the leader, not by the cut
+    float budgetFraction = 0; // of the last round it ran
+    std::vector<SA_raceRun> runs; // of the last round it ran
+    double meanBest = 0;
+    double successRate = 0;
+    double expectedTimeToTarget = 0; // in ms, infinite if no run reached the target
+
+    void summarise()
+    {   // the expected time to target restarts failed runs: the time to target of a successful run plus
+        // (1 - p) / p failed runs
+        meanBest = 0;
+        double successTime = 0, failureTime = 0;
+        int numSuccess = 0;
+        for(SA_raceRun& r : runs)
+        {
+            meanBest += r.bestEval / runs.size();
+            if(r.timeToTarget >= 0)
+            {
+                numSuccess += 1;
+                successTime += r.timeToTarget;
+            }else failureTime += r.runtime;
+        }
+        successRate = runs.empty() ? 0 : static_cast<double>(numSuccess) / runs.size();
+        expectedTimeToTarget = numSuccess == 0 ? std::numeric_limits<double>::infinity()
+                                               : (successTime + failureTime) / numSuccess;
+    }
+};
+
+// one sided 95% quantile of Student's t distribution, exact up to 9 degrees of freedom and from the
+// Cornish-Fisher expansion above (within 0.002)
+inline double SA_tQuantile95(int df)
+{
+    static const double table[] = {6.314, 2.920, 2.353, 2.132, 2.015, 1.943, 1.895, 1.860, 1.833};
+    if(df < 1) return std::numeric_limits<double>::infinity();
+    if(df <= 9) return table[df - 1];
+    double z = 1.6449;
+    return z + (z * z * z + z) / (4 * df) + (5 * std::pow(z, 5) + 16 * z * z * z + 3 * z) / (96.0 * df * df);
+}
+
+// tunes the parameters of an optimisation by successive halving with racing: every round runs the remaining
+// configurations on the same seeds, concurrently on a thread pool, drops the ones whose best f is significantly
+// worse than the leader's (one sided paired t test at 95%) and keeps at most the best 1 / eta of the others. The
+// survivors are run again with twice as many seeds and eta times the budget, the last round with the full budget.
+// Runs go through the run function given to race, which does a run of the parameters with the seed and the
+// fraction of the budget it is given, so the racing does not depend on the problem
+class SA_racing
+{
+public:
+    using runFunction = std::function<SA_raceRun(std::unordered_map<std::string, float>&, uint64_t, float)>;
+
+private:
+    SA_racingSettings _settings;
+    ThreadPool _pool;
+
+    void runRound(std::vector<SA_candidate*>& alive, int round, runFunction& run)
+    {
+        int numSeeds = _settings.initialSeeds << round;
+        float budgetFraction = std::pow(static_cast<float>(_settings.eta), round - _settings.numRounds + 1);
+        for(SA_candidate* c : alive)
+        {
+            c->roundsRun = round + 1;
+            c->budgetFraction = budgetFraction;
+            c->runs.assign(numSeeds, {});
+            for(int k=0; k<numSeeds; k++)
+            {
+                _pool.submit([this, c, k, budgetFraction, &run]()
+                {
+                    std::unordered_map<std::string, float> parameters = c->parameters;
+                    c->runs[k] = run(parameters, _settings.runSeed + k, budgetFraction);
+                });
+            }
+        }
+        _pool.wait();
+        for(SA_candidate* c : alive) c->summarise();
+    }
+
+    bool significantlyWorse(SA_candidate& c, SA_candidate& leader)
+    {   // paired on the seeds, as all the configurations of a round run the same ones
+        SA_welford stats;
+        for(int k=0; k<c.runs.size(); k++) stats.add(c.runs[k].bestEval - leader.runs[k].bestEval);
+        if(stats.count < 2) return false;
+        double stdErr = std::sqrt(stats.m2 / (stats.count - 1) / stats.count);
+        if(stdErr == 0) return stats.mean > 0;
+        return stats.mean / stdErr > SA_tQuantile95(stats.count - 1);
+    }
+
+public:
+    SA_racing(const SA_racingSettings& settings) : _settings(settings), _pool(settings.numThreads) {}
+
+    int numThreads(){ return _pool.size(); }
+
+    // races the base parameters and settings.numConfigurations others, which take the parameters in ranges at
+    // random. Returns all the configurations ranked, the ones that got further first, then by mean best f
+    std::vector<SA_candidate> race(const std::unordered_map<std::string, float>& base,
+                                   std::vector<SA_parameterRange>& ranges, runFunction run)
+    {
+        SA_random gen(_settings.seed);
+        std::vector<SA_candidate> candidates;
+        candidates.push_back({.id = 0, .parameters = base});
+        for(int i=1; i<=_settings.numConfigurations; i++)
+        {
+            candidates.push_back({.id = i, .parameters = base});
+            for(SA_parameterRange& range : ranges) candidates.back().parameters[range.name] = range.sample(gen);
+        }
+
+        std::vector<SA_candidate*> alive;
+        for(SA_candidate& c : candidates) alive.push_back(&c);
+        auto byMeanBest = [](SA_candidate* a, SA_candidate* b){ return a->meanBest < b->meanBest; };
+        for(int round=0; round<_settings.numRounds && !alive.empty(); round++)
+        {
+            runRound(alive, round, run);
+            std::sort(alive.begin(), alive.end(), byMeanBest);
+            if(round == _settings.numRounds - 1) break;
+            std::vector<SA_candidate*> survivors;
+            for(SA_candidate* c : alive)
+            {
+                c->droppedByTest = c != alive.front() && significantlyWorse(*c, *alive.front());
+                if(!c->droppedByTest) survivors.push_back(c);
+            }
+            int numKept = std::max<int>(1, (alive.size() + _settings.eta - 1) / _settings.eta);
+            if(survivors.size() > numKept) survivors.resize(numKept);
+            alive = survivors;
+        }
+
+        std::stable_sort(candidates.begin(), candidates.end(), [](const SA_candidate& a, const SA_candidate& b)
+        {
+            return a.roundsRun != b.roundsRun ? a.roundsRun > b.roundsRun : a.meanBest < b.meanBest;
+        });
+        return candidates;
+    }
+};
+
+#endif // INCLUDE_SA_RACING
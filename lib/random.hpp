@@ -0,0 +1,166 @@
+#ifndef INCLUDE_SA_RANDOM
+#define INCLUDE_SA_RANDOM
+
+#include <cstdint>
+#include <limits>
+#include <random>
+
+// Random numbers for the annealing loop. SA_rng wraps a 64 bit generator with jump() (by default xoshiro256++) and
+// hands out uniform floats from a buffer it fills in bulk. A stream is seeded deterministically from a single
+// integer, and split() gives independent streams (2^128 draws apart) for the problem, for each chain or thread.
+// The generator is pluggable: any UniformRandomBitGenerator with 64 bit results, a constructor from a uint64_t
+// seed and jump() can be used as SA_rng<Generator>
+
+// splitmix64, used to turn a single seed into the state of a generator
+inline uint64_t SA_splitmix64(uint64_t& state)
+{
+    uint64_t z = (state += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+}
+
+// xoshiro256++ by David Blackman and Sebastiano Vigna (https://prng.di.unimi.it)
+class SA_xoshiro256pp
+{
+private:
+    uint64_t _s[4];
+
+    static uint64_t rotl(uint64_t x, int k){ return (x << k) | (x >> (64 - k)); }
+
+public:
+    using result_type = uint64_t;
+
+    SA_xoshiro256pp(uint64_t seed = 0)
+    {
+        for(uint64_t& s : _s) s = SA_splitmix64(seed);
+    }
+
+    static constexpr result_type min(){ return 0; }
+    static constexpr result_type max(){ return std::numeric_limits<uint64_t>::max(); }
+
+    result_type operator()()
+    {
+        uint64_t result = rotl(_s[0] + _s[3], 23) + _s[0];
+        uint64_t t = _s[1] << 17;
+        _s[2] ^= _s[0];
+        _s[3] ^= _s[1];
+        _s[1] ^= _s[2];
+        _s[0] ^= _s[3];
+        _s[2] ^= t;
+        _s[3] = rotl(_s[3], 45);
+        return result;
+    }
+
+    void jump()
+    {   // equivalent to 2^128 calls to operator()
+        static const uint64_t jumpPoly[4] = {0x180ec6d33cfd0aba, 0xd5a61266f0c9392c, 0xa9582618e03fc9aa, 0x39abdc4529b1661c};
+        uint64_t s[4] = {0, 0, 0, 0};
+        for(uint64_t poly : jumpPoly)
+            for(int b=0; b<64; b++)
+            {
+                if(poly & (uint64_t(1) << b))
+                    for(int i=0; i<4; i++) s[i] ^= _s[i];
+                (*this)();
+            }
+        for(int i=0; i<4; i++) _s[i] = s[i];
+    }
+
+    const uint64_t* state() const { return _s; }
+
+    void setState(const uint64_t* state){ for(int i=0; i<4; i++) _s[i] = state[i]; }
+};
+
+template <typename Generator>
+class SA_rng
+{
+public:
+    static const int bufferSize = 256; // uniforms made at once, two per 64 bit draw
+
+private:
+    Generator _gen;
+    float _buffer[bufferSize];
+    int _pos; // next unused uniform in the buffer
+
+    void refill()
+    {
+        const float scale = 1.0f / (1 << 24);
+        for(int i=0; i<bufferSize; i+=2)
+        {   // the top 24 bits of each half of the draw give a float in [0, 1) with every mantissa bit random
+            uint64_t r = _gen();
+            _buffer[i] = (r >> 40) * scale;
+            _buffer[i + 1] = ((r >> 8) & 0xffffff) * scale;
+        }
+        _pos = 0;
+    }
+
+public:
+    SA_rng(uint64_t seed = 0) : _gen(seed), _buffer{}, _pos(bufferSize) {}
+
+    // uniform in [0, 1)
+    float uniform()
+    {
+        if(_pos == bufferSize) refill();
+        return _buffer[_pos++];
+    }
+
+    // uniform in [lower, upper]
+    float uniform(float lower, float upper){ return lower + (upper - lower) * uniform(); }
+
+    // n uniforms in [lower, upper] written to out
+    void fillUniform(float* out, int n, float lower, float upper)
+    {
+        for(int i=0; i<n; i++) out[i] = uniform(lower, upper);
+    }
+
+    // uniform integer in [lower, upper], without bias (Lemire's multiply and reject)
+    int uniformInt(int lower, int upper)
+    {
+        uint32_t range = static_cast<uint32_t>(upper - lower) + 1;
+        uint64_t m = static_cast<uint64_t>(static_cast<uint32_t>(_gen() >> 32)) * range;
+        if(static_cast<uint32_t>(m) < range)
+        {
+            uint32_t threshold = -range % range;
+            while(static_cast<uint32_t>(m) < threshold)
+                m = static_cast<uint64_t>(static_cast<uint32_t>(_gen() >> 32)) * range;
+        }
+        return lower + static_cast<int>(m >> 32);
+    }
+
+    // raw 64 bit draw
+    uint64_t next(){ return _gen(); }
+
+    // an independent stream: the returned one continues from the current state, and this one jumps 2^128 draws
+    // ahead. The uniforms still in the buffer were made before the split, so the two streams never overlap
+    SA_rng split()
+    {
+        SA_rng child;
+        child._gen = _gen;
+        _gen.jump();
+        return child;
+    }
+
+    Generator& generator(){ return _gen; }
+
+    // the uniforms left in the buffer are part of the state of the stream
+    int bufferPosition(){ return _pos; }
+
+    const float* buffer(){ return _buffer; }
+
+    void setBuffer(const float* buffer, int pos)
+    {
+        for(int i=0; i<bufferSize; i++) _buffer[i] = buffer[i];
+        _pos = pos;
+    }
+};
+
+using SA_random = SA_rng<SA_xoshiro256pp>;
+
+// a seed for runs without one, 64 random bits so that the runs of an ensemble or a server do not collide
+inline uint64_t SA_randomSeed()
+{
+    std::random_device device;
+    return (static_cast<uint64_t>(device()) << 32) ^ device();
+}
+
+#endif // INCLUDE_SA_RANDOM
@@ -0,0 +1,443 @@
+#ifndef INCLUDE_SA_RECORDER
+#define INCLUDE_SA_RECORDER
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "checkpoint.hpp"
+
+// Recorders keep the trajectory of an optimisation. SA_engine takes the recorder as a template parameter and calls
+//   void start(T& initialSoln)                                          before the first iteration
+//   void recordStep(long iteration, T& currSoln, float temperature, float acceptProb)   on every iteration
+//   void recordAccepted(long iteration, T& acceptedSoln)               on every accepted solution
+//   void finish()                                                       after the last iteration
+//   void saveState(SA_snapshotWriter&)                                  when the engine writes a snapshot
+//   void loadState(SA_snapshotReader&)                                  instead of start() when a run resumes
+// available recorders are
+//   SA_nullRecorder       records nothing, compiles away entirely
+//   SA_decimatedRecorder  keeps every n-th iteration in memory (n = 1 keeps the full trajectory)
+//   SA_ringRecorder       keeps the last n iterations in a fixed size buffer
+//   SA_streamRecorder     streams fixed width binary records to a file from a background thread
+
+struct SA_recorderSettings
+{
+    long interval; // SA_decimatedRecorder keeps every interval-th iteration
+    long capacity; // SA_ringRecorder keeps the last capacity iterations
+    std::string fileName; // SA_streamRecorder writes to this file
+
+    static SA_recorderSettings fromParameters(std::unordered_map<std::string, float>& parameters)
+    {
+        return {
+            .interval = parameters.count("record interval") ? static_cast<long>(parameters["record interval"]) : 1,
+            .capacity = parameters.count("record capacity") ? static_cast<long>(parameters["record capacity"]) : 10000,
+            .fileName = "trajectory.bin"
+        };
+    }
+};
+
+// how a solution is written into a binary record: as numFields floats, the coordinates followed by the
+// objective value. Specialise this for solution types without size(), getX() and getEval()
+template <typename T>
+struct SA_recordTraits
+{
+    static int numFields(T& s){ return s.size() + 1; }
+
+    static void write(T& s, float* out)
+    {
+        for(int i=0; i<s.size(); i++) out[i] = s.getX(i);
+        out[s.size()] = s.getEval();
+    }
+};
+
+template <typename T>
+class SA_nullRecorder
+{
+public:
+    SA_nullRecorder(const SA_recorderSettings& settings = {}) {}
+    void start(T& initialSoln) {}
+    void recordStep(long iteration, T& currSoln, float temperature, float acceptProb) {}
+    void recordAccepted(long iteration, T& acceptedSoln) {}
+    void finish() {}
+    void saveState(SA_snapshotWriter& writer) {}
+    void loadState(SA_snapshotReader& reader) {}
+};
+
+template <typename T>
+class SA_decimatedRecorder
+{
+private:
+    long _interval;
+    long _numAccepted;
+    std::vector<T> _allSolns;
+    std::vector<float> _annealingSchedule;
+    std::vector<float> _acceptProbs;
+    std::vector<T> _allAcceptedSolns;
+
+public:
+    SA_decimatedRecorder(const SA_recorderSettings& settings = {1, 0, ""})
+        : _interval(settings.interval > 0 ? settings.interval : 1), _numAccepted(0) {}
+
+    void start(T& initialSoln)
+    {
+        _numAccepted = 0;
+        _allSolns.clear();
+        _annealingSchedule.clear();
+        _acceptProbs.clear();
+        _allAcceptedSolns.clear();
+    }
+
+    void recordStep(long iteration, T& currSoln, float temperature, float acceptProb)
+    {
+        if(iteration % _interval != 0) return;
+        _allSolns.push_back(currSoln);
+        _annealingSchedule.push_back(temperature);
+        _acceptProbs.push_back(acceptProb);
+    }
+
+    void recordAccepted(long iteration, T& acceptedSoln)
+    {
+        if(_numAccepted++ % _interval == 0) _allAcceptedSolns.push_back(acceptedSoln);
+    }
+
+    void finish() {}
+
+    void saveState(SA_snapshotWriter& writer)
+    {   // the whole trajectory kept so far
+        writer.write(_numAccepted);
+        SA_saveVector(writer, _allSolns);
+        SA_saveVector(writer, _annealingSchedule);
+        SA_saveVector(writer, _acceptProbs);
+        SA_saveVector(writer, _allAcceptedSolns);
+    }
+
+    void loadState(SA_snapshotReader& reader)
+    {
+        reader.read(_numAccepted);
+        SA_loadVector(reader, _allSolns);
+        SA_loadVector(reader, _annealingSchedule);
+        SA_loadVector(reader, _acceptProbs);
+        SA_loadVector(reader, _allAcceptedSolns);
+    }
+
+    void printAllToFile(const std::string fileName)
+    {   // prints the recorded optimisation journey to file
+        // each line is: [solution], temperature, acceptProb
+        std::ofstream outfile;
+        outfile.open(fileName, std::ios::out|std::ios::trunc);
+        for(int i=0; i<_allSolns.size(); i++)
+        {
+            outfile << _allSolns[i] << ", "
+                    << _annealingSchedule[i] << ", "
+                    << _acceptProbs[i] << '\n';
+        }
+        outfile.close();
+    }
+
+    void printAcceptedToFile(const std::string fileName)
+    {   // prints only accepted solutions to file
+        // each line is: [solution]
+        std::ofstream outfile;
+        outfile.open(fileName, std::ios::out|std::ios::trunc);
+        for(T& s : _allAcceptedSolns)
+        {
+            outfile << s << '\n';
+        }
+        outfile.close();
+    }
+};
+
+template <typename T>
+class SA_ringRecorder
+{
+private:
+    struct step
+    {
+        T soln;
+        float temperature;
+        float acceptProb;
+    };
+
+    std::vector<step> _steps; // allocated once, then overwritten in a circle
+    std::vector<T> _acceptedSolns;
+    long _numSteps;
+    long _numAccepted;
+
+public:
+    SA_ringRecorder(const SA_recorderSettings& settings = {0, 10000, ""})
+        : _steps(settings.capacity > 0 ? settings.capacity : 1),
+          _acceptedSolns(settings.capacity > 0 ? settings.capacity : 1), _numSteps(0), _numAccepted(0) {}
+
+    void start(T& initialSoln)
+    {
+        _numSteps = 0;
+        _numAccepted = 0;
+    }
+
+    void recordStep(long iteration, T& currSoln, float temperature, float acceptProb)
+    {
+        step& s = _steps[_numSteps++ % _steps.size()];
+        s.soln = currSoln;
+        s.temperature = temperature;
+        s.acceptProb = acceptProb;
+    }
+
+    void recordAccepted(long iteration, T& acceptedSoln)
+    {
+        _acceptedSolns[_numAccepted++ % _acceptedSolns.size()] = acceptedSoln;
+    }
+
+    void finish() {}
+
+    void saveState(SA_snapshotWriter& writer)
+    {   // the buffers as they are, with their capacity
+        writer.write(_numSteps);
+        writer.write(_numAccepted);
+        writer.write(static_cast<uint64_t>(_steps.size()));
+        for(step& s : _steps)
+        {
+            SA_snapshotTraits<T>::save(writer, s.soln);
+            writer.write(s.temperature);
+            writer.write(s.acceptProb);
+        }
+        SA_saveVector(writer, _acceptedSolns);
+    }
+
+    void loadState(SA_snapshotReader& reader)
+    {
+        reader.read(_numSteps);
+        reader.read(_numAccepted);
+        uint64_t size;
+        reader.read(size);
+        _steps.resize(size);
+        for(step& s : _steps)
+        {
+            SA_snapshotTraits<T>::load(reader, s.soln);
+            reader.read(s.temperature);
+            reader.read(s.acceptProb);
+        }
+        SA_loadVector(reader, _acceptedSolns);
+    }
+
+    void printAllToFile(const std::string fileName)
+    {   // prints the last iterations to file, oldest first
+        // each line is: [solution], temperature, acceptProb
+        std::ofstream outfile;
+        outfile.open(fileName, std::ios::out|std::ios::trunc);
+        long first = _numSteps > _steps.size() ? _numSteps - _steps.size() : 0;
+        for(long i=first; i<_numSteps; i++)
+        {
+            step& s = _steps[i % _steps.size()];
+            outfile << s.soln << ", " << s.temperature << ", " << s.acceptProb << '\n';
+        }
+        outfile.close();
+    }
+
+    void printAcceptedToFile(const std::string fileName)
+    {   // prints the last accepted solutions to file, oldest first
+        // each line is: [solution]
+        std::ofstream outfile;
+        outfile.open(fileName, std::ios::out|std::ios::trunc);
+        long first = _numAccepted > _acceptedSolns.size() ? _numAccepted - _acceptedSolns.size() : 0;
+        for(long i=first; i<_numAccepted; i++) outfile << _acceptedSolns[i % _acceptedSolns.size()] << '\n';
+        outfile.close();
+    }
+};
+
+// binary trajectory file layout (in the byte order of the machine that wrote it):
+//   header: char[4] "SATR", uint32 version, uint32 numFields, uint32 recordSize
+//   records of recordSize bytes: int64 iteration, uint32 kind (0 = iteration, 1 = accepted solution),
+//                                float fields[numFields], float temperature, float acceptProb
+// for accepted solutions temperature and acceptProb are 0. SA_convert turns the file into the text files of
+// printAllToFile and printAcceptedToFile
+struct SA_trajectoryHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t numFields;
+    uint32_t recordSize;
+};
+
+const uint32_t SA_trajectoryVersion = 1;
+const uint32_t SA_stepRecord = 0;
+const uint32_t SA_acceptedRecord = 1;
+
+inline uint32_t SA_trajectoryRecordSize(uint32_t numFields)
+{
+    return sizeof(int64_t) + sizeof(uint32_t) + (numFields + 2) * sizeof(float);
+}
+
+template <typename T>
+class SA_streamRecorder
+{
+private:
+    static const size_t bufferSize = 1 << 20; // bytes per buffer
+
+    std::string _fileName;
+    std::ofstream _outfile;
+    uint32_t _numFields;
+    uint32_t _recordSize;
+    std::vector<float> _values; // fields of the record being written
+    std::vector<char> _buffers[2];
+    size_t _used; // bytes used in the buffer being filled
+    int _active; // buffer being filled by the optimisation thread
+
+    // the background writer owns the other buffer while _pending is set
+    std::thread _writer;
+    std::mutex _mtx;
+    std::condition_variable _cv;
+    bool _pending;
+    size_t _pendingSize;
+    bool _stop;
+    long _numRecords;
+
+    void writerLoop()
+    {
+        std::unique_lock<std::mutex> lock(_mtx);
+        while(true)
+        {
+            _cv.wait(lock, [this]{ return _pending || _stop; });
+            if(_pending)
+            {
+                int idx = 1 - _active;
+                size_t size = _pendingSize;
+                lock.unlock();
+                _outfile.write(_buffers[idx].data(), size);
+                lock.lock();
+                _pending = false;
+                _cv.notify_all();
+            }else if(_stop) return;
+        }
+    }
+
+    void handOver()
+    {   // give the filled buffer to the writer and continue in the other one
+        std::unique_lock<std::mutex> lock(_mtx);
+        _cv.wait(lock, [this]{ return !_pending; });
+        _active = 1 - _active;
+        _pendingSize = _used;
+        _pending = true;
+        _used = 0;
+        _cv.notify_all();
+    }
+
+    char* nextRecord(long iteration, uint32_t kind)
+    {
+        if(_used + _recordSize > bufferSize) handOver();
+        char* record = _buffers[_active].data() + _used;
+        int64_t it = iteration;
+        std::memcpy(record, &it, sizeof(it));
+        std::memcpy(record + sizeof(it), &kind, sizeof(kind));
+        _used += _recordSize;
+        _numRecords += 1;
+        return record + sizeof(it) + sizeof(kind);
+    }
+
+    void stopWriter()
+    {
+        if(!_writer.joinable()) return;
+        if(_used > 0) handOver();
+        {
+            std::unique_lock<std::mutex> lock(_mtx);
+            _cv.wait(lock, [this]{ return !_pending; });
+            _stop = true;
+        }
+        _cv.notify_all();
+        _writer.join();
+        _outfile.close();
+    }
+
+public:
+    SA_streamRecorder(const SA_recorderSettings& settings = {0, 0, "trajectory.bin"})
+        : _fileName(settings.fileName), _numFields(0), _recordSize(0), _used(0), _active(0),
+          _pending(false), _pendingSize(0), _stop(false), _numRecords(0)
+    {
+        _buffers[0].resize(bufferSize);
+        _buffers[1].resize(bufferSize);
+    }
+
+    ~SA_streamRecorder(){ stopWriter(); }
+
+    void start(T& initialSoln)
+    {
+        stopWriter();
+        _numFields = SA_recordTraits<T>::numFields(initialSoln);
+        _recordSize = SA_trajectoryRecordSize(_numFields);
+        _values.assign(_numFields + 2, 0);
+        _used = 0;
+        _active = 0;
+        _pending = false;
+        _stop = false;
+        _numRecords = 0;
+        _outfile.open(_fileName, std::ios::out|std::ios::trunc|std::ios::binary);
+        SA_trajectoryHeader header{{'S', 'A', 'T', 'R'}, SA_trajectoryVersion, _numFields, _recordSize};
+        _outfile.write(reinterpret_cast<char*>(&header), sizeof(header));
+        _writer = std::thread(&SA_streamRecorder::writerLoop, this);
+    }
+
+    void recordStep(long iteration, T& currSoln, float temperature, float acceptProb)
+    {
+        SA_recordTraits<T>::write(currSoln, _values.data());
+        _values[_numFields] = temperature;
+        _values[_numFields + 1] = acceptProb;
+        std::memcpy(nextRecord(iteration, SA_stepRecord), _values.data(), _values.size() * sizeof(float));
+    }
+
+    void recordAccepted(long iteration, T& acceptedSoln)
+    {
+        SA_recordTraits<T>::write(acceptedSoln, _values.data());
+        _values[_numFields] = 0;
+        _values[_numFields + 1] = 0;
+        std::memcpy(nextRecord(iteration, SA_acceptedRecord), _values.data(), _values.size() * sizeof(float));
+    }
+
+    // flushes the remaining records and closes the file
+    void finish(){ stopWriter(); }
+
+    void saveState(SA_snapshotWriter& writer)
+    {   // where the trajectory ends: every record so far is flushed to the file first
+        if(_used > 0) handOver();
+        {
+            std::unique_lock<std::mutex> lock(_mtx);
+            _cv.wait(lock, [this]{ return !_pending; });
+            _outfile.flush();
+        }
+        writer.write(_numFields);
+        writer.write(_recordSize);
+        writer.write(_numRecords);
+    }
+
+    void loadState(SA_snapshotReader& reader)
+    {   // cuts the records written after the snapshot from the file and appends from there
+        stopWriter();
+        reader.read(_numFields);
+        reader.read(_recordSize);
+        reader.read(_numRecords);
+        _values.assign(_numFields + 2, 0);
+        _used = 0;
+        _active = 0;
+        _pending = false;
+        _stop = false;
+        uintmax_t size = sizeof(SA_trajectoryHeader) + static_cast<uintmax_t>(_numRecords) * _recordSize;
+        std::error_code error;
+        if(std::filesystem::file_size(_fileName, error) < size || error)
+            throw std::runtime_error(_fileName + " is shorter than the trajectory in the snapshot");
+        std::filesystem::resize_file(_fileName, size);
+        _outfile.open(_fileName, std::ios::out|std::ios::app|std::ios::binary);
+        _writer = std::thread(&SA_streamRecorder::writerLoop, this);
+    }
+
+    // number of records written since start()
+    long getNumRecords(){ return _numRecords; }
+
+    const std::string& getFileName(){ return _fileName; }
+};
+
+#endif // INCLUDE_SA_RECORDER
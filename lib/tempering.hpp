@@ -0,0 +1,216 @@
+#ifndef INCLUDE_SA_TEMPERING
+#define INCLUDE_SA_TEMPERING
+
+#include <cmath>
+#include <condition_variable>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "engine.hpp"
+
+// whether the problem policy can divide the budgets it keeps in its context between runs sharing them
+template <typename Problem, typename = void>
+struct SA_hasSharedBudget : std::false_type {};
+
+template <typename Problem>
+struct SA_hasSharedBudget<Problem, std::void_t<decltype(Problem::shareBudget(
+    std::declval<typename Problem::context_type&>(), 0))>>
+    : std::true_type {};
+
+struct SA_temperingSettings
+{
+    int numChains;
+    float temperatureRatio; // chain k starts at the initial temperature * temperatureRatio^k
+    int exchangeInterval; // number of iterations every chain does between two exchange steps
+
+    static SA_temperingSettings fromParameters(std::unordered_map<std::string, float>& parameters)
+    {
+        return {
+            .numChains = parameters.count("tempering chains") ? static_cast<int>(parameters["tempering chains"]) : 4,
+            .temperatureRatio = parameters.count("tempering ratio") ? parameters["tempering ratio"] : 0.5f,
+            .exchangeInterval = parameters.count("exchange interval") ? static_cast<int>(parameters["exchange interval"]) : 100
+        };
+    }
+};
+
+// barrier for a fixed number of threads. The last thread to arrive runs the completion step, while all the
+// others are still blocked, and then releases them
+class SA_barrier
+{
+private:
+    std::mutex _mtx;
+    std::condition_variable _cv;
+    int _numThreads;
+    int _numWaiting;
+    long _generation;
+
+public:
+    SA_barrier(int numThreads) : _numThreads(numThreads), _numWaiting(0), _generation(0) {}
+
+    template <typename F>
+    void arriveAndWait(F&& completion)
+    {
+        std::unique_lock<std::mutex> lock(_mtx);
+        long generation = _generation;
+        if(++_numWaiting == _numThreads)
+        {
+            completion();
+            _numWaiting = 0;
+            _generation += 1;
+            _cv.notify_all();
+        }else
+        {
+            _cv.wait(lock, [this, generation]{ return generation != _generation; });
+        }
+    }
+};
+
+// replica exchange (parallel tempering) on top of SA_engine. K chains run on their own thread from a single initial
+// search (the one of chain 0), on a ladder of temperatures: chain k is at temperatureRatio^k times the temperature of
+// chain 0, which cools down with the problem's own schedule. Every exchangeInterval iterations the chains meet at a
+// barrier, the ladder is set again from chain 0 (so the chains cool together, whatever their own schedules did in
+// between) and neighbouring chains swap their current solutions with the Metropolis criterion
+// min(1, exp((E_i - E_j) * (1/T_i - 1/T_j))), alternating between the even pairs (0,1),(2,3).. and the odd pairs
+// (1,2),(3,4).. Temperatures are kept above the smallest normal float, so the criterion stays defined as they cool.
+// The chains share the budget of a single run: each one gets 1/K of "max iterations" and, through the problem's
+// shareBudget(ctx, K) if it has one, of the budgets it keeps in its context (like Schwefel's "max eval").
+// On top of the SA_engine methods the problem policy needs getEnergy
+template <typename Problem>
+class SA_tempering
+{
+public:
+    using engine_type = SA_engine<Problem>;
+    using soln_type = typename Problem::soln_type;
+    using context_type = typename Problem::context_type;
+
+private:
+    std::vector<engine_type> _chains;
+    SA_temperingSettings _temperingSettings;
+    std::vector<long> _numSwapAttempts; // for the pair (k, k+1)
+    std::vector<long> _numSwapAccepts;
+    SA_random _randGen;
+    static constexpr float minTemperature = std::numeric_limits<float>::min();
+    long _numExchanges;
+    bool _allFinished;
+
+    void runChain(int k, SA_barrier& barrier)
+    {
+        engine_type& chain = _chains[k];
+        while(true)
+        {
+            for(int i=0; i<_temperingSettings.exchangeInterval && !chain.isFinished(); i++) chain.step();
+            barrier.arriveAndWait([this]{ exchange(); });
+            if(_allFinished) return;
+        }
+    }
+
+    void exchange()
+    {   // only runs while every chain is waiting at the barrier
+        setLadder();
+        for(int k=_numExchanges % 2; k+1<_chains.size(); k+=2) trySwap(k, k+1);
+        _numExchanges += 1;
+        _allFinished = true;
+        for(engine_type& chain : _chains) _allFinished &= chain.isFinished();
+    }
+
+    void setLadder()
+    {
+        double temperature = std::max(_chains[0]._runtimeInfo.temperature, minTemperature);
+        for(engine_type& chain : _chains)
+        {
+            chain._runtimeInfo.temperature = std::max(static_cast<float>(temperature), minTemperature);
+            temperature *= _temperingSettings.temperatureRatio;
+        }
+    }
+
+    void trySwap(int i, int j)
+    {
+        engine_type& a = _chains[i];
+        engine_type& b = _chains[j];
+        if(a.isFinished() || b.isFinished()) return;
+        double ea = Problem::getEnergy(a._ctx, a._currSoln);
+        double eb = Problem::getEnergy(b._ctx, b._currSoln);
+        double betaA = 1.0 / a._runtimeInfo.temperature; // finite, the ladder keeps temperatures above minTemperature
+        double betaB = 1.0 / b._runtimeInfo.temperature;
+        double swapProb = std::exp((ea - eb) * (betaA - betaB));
+        _numSwapAttempts[i] += 1;
+        if(_randGen.uniform() < swapProb)
+        {
+            a.syncBest();
+            b.syncBest();
+            std::swap(a._currSoln, b._currSoln);
+            a.checkBest();
+            b.checkBest();
+            _numSwapAccepts[i] += 1;
+        }
+    }
+
+public:
+    SA_tempering(const context_type& ctx, const SA_settings& settings, const SA_temperingSettings& temperingSettings)
+        : _temperingSettings(temperingSettings), _numExchanges(0), _allFinished(false)
+    {
+        if(_temperingSettings.numChains < 1) _temperingSettings.numChains = 1;
+        // every chain and the exchange step run on their own split of the stream seeded with settings.seed
+        SA_random stream(settings.seed);
+        context_type chainCtx = ctx;
+        if constexpr (SA_hasSharedBudget<Problem>::value) Problem::shareBudget(chainCtx, _temperingSettings.numChains);
+        _chains.reserve(_temperingSettings.numChains);
+        for(int k=0; k<_temperingSettings.numChains; k++)
+        {
+            SA_settings chainSettings = settings;
+            chainSettings.maxIterations = (settings.maxIterations + _temperingSettings.numChains - 1) / _temperingSettings.numChains;
+            chainSettings.verbose = false;
+            chainSettings.speculativeThreads = 0; // every chain has a thread of its own already
+            _chains.emplace_back(chainCtx, chainSettings, stream.split());
+        }
+        _randGen = stream.split();
+    }
+
+    void optimise()
+    {
+        _chains[0].initialise();
+        for(int k=1; k<_chains.size(); k++) _chains[k].initialise(_chains[0]._runtimeInfo);
+        setLadder();
+        _numSwapAttempts.assign(_chains.size() - 1, 0);
+        _numSwapAccepts.assign(_chains.size() - 1, 0);
+        _numExchanges = 0;
+        _allFinished = false;
+
+        SA_barrier barrier(_chains.size());
+        std::vector<std::thread> threads;
+        for(int k=0; k<_chains.size(); k++) threads.emplace_back(&SA_tempering::runChain, this, k, std::ref(barrier));
+        for(std::thread& t : threads) t.join();
+        for(engine_type& chain : _chains) chain.syncBest();
+    }
+
+    // the curr solution of the coldest chain and the best solution found by any chain
+    std::pair<soln_type, soln_type> getOptimisationResult()
+    {
+        engine_type& coldest = _chains.back();
+        soln_type best = _chains[0]._bestSoln;
+        for(engine_type& chain : _chains)
+            if(Problem::compareSoln(chain._ctx, chain._bestSoln, best)) best = chain._bestSoln;
+        return {coldest._currSoln, best};
+    }
+
+    // fraction of accepted swaps between chain k and chain k+1
+    std::vector<float> getSwapAcceptanceRates()
+    {
+        std::vector<float> rates;
+        for(int k=0; k+1<_chains.size(); k++)
+            rates.push_back(_numSwapAttempts[k] > 0 ? static_cast<float>(_numSwapAccepts[k]) / _numSwapAttempts[k] : 0);
+        return rates;
+    }
+
+    long getNumExchanges(){ return _numExchanges; }
+
+    int getNumChains(){ return _chains.size(); }
+
+    engine_type& getChain(int k){ return _chains[k]; }
+};
+
+#endif // INCLUDE_SA_TEMPERING
@@ -0,0 +1,127 @@
+#ifndef INCLUDE_SA_THREAD_POOL
+#define INCLUDE_SA_THREAD_POOL
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// work stealing thread pool: every worker has its own queue of tasks, it takes tasks from the back of its own
+// queue and steals from the front of the other queues once its own queue is empty
+class ThreadPool
+{
+private:
+    struct workerQueue
+    {
+        std::mutex mtx;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<workerQueue>> _queues;
+    std::vector<std::thread> _threads;
+    std::mutex _mtx;
+    std::condition_variable _taskAvailable;
+    std::condition_variable _allDone;
+    std::atomic<long> _numQueued{0}; // tasks waiting in a queue
+    std::atomic<long> _numPending{0}; // tasks submitted but not finished yet
+    std::atomic<unsigned> _nextQueue{0};
+    bool _stop = false;
+
+    bool popTask(int idx, std::function<void()>& task)
+    {
+        {   // own queue first
+            std::lock_guard<std::mutex> lock(_queues[idx]->mtx);
+            if(!_queues[idx]->tasks.empty())
+            {
+                task = std::move(_queues[idx]->tasks.back());
+                _queues[idx]->tasks.pop_back();
+                return true;
+            }
+        }
+        for(int i=1; i<_queues.size(); i++)
+        {   // then steal the oldest task of another worker
+            workerQueue& victim = *_queues[(idx + i) % _queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mtx);
+            if(!victim.tasks.empty())
+            {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void workerLoop(int idx)
+    {
+        std::function<void()> task;
+        while(true)
+        {
+            if(popTask(idx, task))
+            {
+                _numQueued -= 1;
+                task();
+                task = nullptr;
+                if(--_numPending == 0)
+                {
+                    std::lock_guard<std::mutex> lock(_mtx);
+                    _allDone.notify_all();
+                }
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(_mtx);
+            _taskAvailable.wait(lock, [this]{ return _stop || _numQueued > 0; });
+            if(_stop && _numQueued == 0) return;
+        }
+    }
+
+public:
+    ThreadPool(int numThreads = std::thread::hardware_concurrency())
+    {
+        if(numThreads < 1) numThreads = 1;
+        for(int i=0; i<numThreads; i++) _queues.push_back(std::make_unique<workerQueue>());
+        for(int i=0; i<numThreads; i++) _threads.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+            _stop = true;
+        }
+        _taskAvailable.notify_all();
+        for(std::thread& t : _threads) t.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size(){ return _threads.size(); }
+
+    void submit(std::function<void()> task)
+    {   // tasks are spread round robin over the worker queues, idle workers steal the rest
+        workerQueue& queue = *_queues[_nextQueue++ % _queues.size()];
+        _numPending += 1;
+        {
+            std::lock_guard<std::mutex> lock(queue.mtx);
+            queue.tasks.push_back(std::move(task));
+        }
+        _numQueued += 1;
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+        }
+        _taskAvailable.notify_one();
+    }
+
+    void wait()
+    {   // block until every submitted task has finished
+        std::unique_lock<std::mutex> lock(_mtx);
+        _allDone.wait(lock, [this]{ return _numPending == 0; });
+    }
+};
+
+#endif // INCLUDE_SA_THREAD_POOL
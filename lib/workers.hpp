@@ -0,0 +1,134 @@
+#ifndef INCLUDE_SA_WORKERS
+#define INCLUDE_SA_WORKERS
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#define SA_PIN_THREADS
+#endif
+
+// a small fixed set of threads for running the iterations of a short parallel loop with as little latency as
+// possible, used by SA_engine to evaluate the proposals of a single step in parallel. Unlike ThreadPool there is
+// no queue and no allocation per task: run(n, f) calls f(0) .. f(n-1) on the workers and the calling thread, and
+// returns when all of them are done. Idle workers spin for a while before they sleep, so back to back loops (one
+// per annealing step) do not pay for waking them up. With pinning asked for, worker k is pinned to the (k + 1)-th
+// cpu (cyclically) of those the process may run on, leaving the first one to the calling thread. Pinning is off by
+// default: pools of concurrent engines would all pin their workers to the same cpus
+class SA_workerPool
+{
+private:
+    static const int spinCount = 1 << 14; // checks for a new loop before sleeping
+
+    std::vector<std::thread> _threads;
+    std::mutex _mtx;
+    std::condition_variable _cv;
+    std::atomic<long> _generation{0}; // number of loops started
+    std::atomic<int> _next{0}; // next iteration of the current loop to run
+    std::atomic<int> _numBusy{0}; // workers still in the current loop
+    int _n = 0;
+    void (*_call)(void*, int) = nullptr;
+    void* _loop = nullptr;
+    bool _stop = false;
+    bool _pin;
+
+    void work()
+    {
+        for(int i=_next.fetch_add(1); i<_n; i=_next.fetch_add(1)) _call(_loop, i);
+    }
+
+    bool waitForLoop(long& seen)
+    {   // returns false when the pool stops
+        for(int spin=0; spin<spinCount; spin++)
+        {
+            if(_generation.load(std::memory_order_acquire) != seen)
+            {
+                seen = _generation.load(std::memory_order_acquire);
+                return true;
+            }
+            if(spin % 64 == 63) std::this_thread::yield();
+        }
+        std::unique_lock<std::mutex> lock(_mtx);
+        _cv.wait(lock, [this, seen]{ return _stop || _generation.load() != seen; });
+        if(_stop) return false;
+        seen = _generation.load();
+        return true;
+    }
+
+    void workerLoop(int idx)
+    {
+        pin(idx);
+        long seen = 0;
+        while(waitForLoop(seen))
+        {
+            work();
+            _numBusy.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    void pin(int idx)
+    {
+#ifdef SA_PIN_THREADS
+        if(!_pin) return;
+        cpu_set_t allowed; // the process affinity mask, which taskset or a cgroup cpuset may restrict
+        if(sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return;
+        std::vector<int> cpus;
+        for(int cpu=0; cpu<CPU_SETSIZE; cpu++)
+            if(CPU_ISSET(cpu, &allowed)) cpus.push_back(cpu);
+        if(cpus.size() < 2) return;
+        cpu_set_t target;
+        CPU_ZERO(&target);
+        CPU_SET(cpus[(idx + 1) % cpus.size()], &target);
+        pthread_setaffinity_np(pthread_self(), sizeof(target), &target);
+#endif
+    }
+
+public:
+    SA_workerPool(int numThreads, bool pinThreads = false) : _pin(pinThreads)
+    {
+        for(int i=0; i<numThreads; i++) _threads.emplace_back(&SA_workerPool::workerLoop, this, i);
+    }
+
+    ~SA_workerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+            _stop = true;
+        }
+        _cv.notify_all();
+        for(std::thread& t : _threads) t.join();
+    }
+
+    SA_workerPool(const SA_workerPool&) = delete;
+    SA_workerPool& operator=(const SA_workerPool&) = delete;
+
+    int size(){ return _threads.size(); }
+
+    bool isPinned(){ return _pin; }
+
+    template <typename F>
+    void run(int n, F&& f)
+    {
+        _loop = &f;
+        _call = [](void* loop, int i){ (*static_cast<std::remove_reference_t<F>*>(loop))(i); };
+        _n = n;
+        _next.store(0);
+        _numBusy.store(_threads.size());
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+            _generation.fetch_add(1, std::memory_order_release);
+        }
+        _cv.notify_all();
+        work();
+        for(int spin=1; _numBusy.load(std::memory_order_acquire) > 0; spin++)
+            if(spin % 64 == 0) std::this_thread::yield();
+    }
+};
+
+#endif // INCLUDE_SA_WORKERS
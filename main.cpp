@@ -3,42 +3,144 @@
 #include <string>
 #include <unordered_map>
 #include <chrono>
+#include <stdexcept>
 #include "lib/core.hpp"
+#include "lib/json.hpp"
 #include "third_party/nlohmann/json.hpp"
 #include "Example/SchwefelFunction/problem.hpp"
 
-int main(int argc, 
+// write out the trajectory kept by the recorder of the optimisation
+template <typename T>
+void saveTrajectory(SA_nullRecorder<T>& recorder) {}
+
+template <typename T>
+void saveTrajectory(SA_decimatedRecorder<T>& recorder)
+{
+    std::cout << "results saved to allSolutions.txt and acceptedSolutions.txt\n";
+    recorder.printAllToFile("allSolutions.txt");
+    recorder.printAcceptedToFile("acceptedSolutions.txt");
+}
+
+template <typename T>
+void saveTrajectory(SA_ringRecorder<T>& recorder)
+{
+    std::cout << "last iterations saved to allSolutions.txt and acceptedSolutions.txt\n";
+    recorder.printAllToFile("allSolutions.txt");
+    recorder.printAcceptedToFile("acceptedSolutions.txt");
+}
+
+template <typename T>
+void saveTrajectory(SA_streamRecorder<T>& recorder)
+{
+    std::cout << recorder.getNumRecords() << " records streamed to " << recorder.getFileName()
+              << ", convert them with SA_convert\n";
+}
+
+template <typename SAType>
+void runSA(SAType& SAinst, std::unordered_map<std::string, float>& jmap, const std::string& resumeFile)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    if(resumeFile.empty()) SAinst.optimise();
+    else SAinst.resume(resumeFile);
+    auto finish = std::chrono::high_resolution_clock::now();
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(finish-start).count();
+    std::cout << "seed: " << SAinst.getSettings().seed << '\n';
+    std::cout << "Optimisation took " << elapsed / 1000 << "ms\n";
+    // a resumed run only did the iterations after its snapshot in that time
+    long numIterations = SAinst.getNumIterations() - SAinst.getNumResumedIterations();
+    std::cout << "iterations per second: " << (elapsed > 0 ? numIterations * 1e6 / elapsed : 0) << '\n';
+    saveTrajectory(SAinst.getRecorder());
+    std::cout << "number of coordinate evaluations: " << SAinst.getContext().num_of_evaluations << '\n';
+    std::cout << "number of pre-search coordinate evaluations: " << SAinst.getContext().num_of_initial_evaluations << '\n';
+    std::cout << "final temperature: " << SAinst.getRuntimeInfo().temperature << '\n';
+    if constexpr (SA_instrumentEnabled)
+    {
+        auto& instrumentation = SAinst.getInstrumentation();
+        for(int p=0; p<SA_numPhases; p++)
+            std::cout << SA_phaseName(p) << ": " << instrumentation.getPhaseNs(static_cast<SA_phase>(p)) / 1e6 << "ms\n";
+        std::cout << instrumentation.getTemperatureSteps().size() << " temperature steps and "
+                  << instrumentation.getRestarts().size() << " restarts saved to instrumentation.json\n";
+        instrumentation.writeJson("instrumentation.json");
+    }
+    std::cout << "current solution: " << SAinst.getOptimisationResult().first.print() << '\n';
+    std::cout << "best solution: " << SAinst.getOptimisationResult().second.print() << '\n';
+}
+
+template <int N, typename Recorder>
+void runWithRecorder(std::unordered_map<std::string, float>& jmap, const SA_settings& settings, bool compat,
+                     const std::string& resumeFile)
+{
+    if(compat)
+    {   // go through the function pointers of Schwefel::problemCtx
+        SA<Schwefel::soln<N>, Schwefel::context<N>, Recorder> SAinst(Schwefel::problemCtx<N>, jmap, settings);
+        runSA(SAinst, jmap, resumeFile);
+    }else
+    {
+        SA_engine<Schwefel::Problem<N>, Recorder> SAinst(Schwefel::Problem<N>::createContext(jmap), settings);
+        runSA(SAinst, jmap, resumeFile);
+    }
+}
+
+int main(int argc,
          char *argv[]) {
+    // SA_run <parameters.json> [--compat] [--resume snapshot.bin]
+    // with --resume the run saved in the snapshot (see "checkpoint interval") is continued, it must be given the
+    // same parameters and options as the run that wrote it
+    bool compat = false;
+    std::string resumeFile;
+    std::string badArgument;
+    for(int i=2; i<argc && badArgument.empty(); i++)
+    {
+        std::string arg = argv[i];
+        if(arg == "--compat") compat = true;
+        else if(arg == "--resume" && i + 1 < argc) resumeFile = argv[++i];
+        else badArgument = arg;
+    }
     if(argc<=1)
     {
         std::cout << "missing paramters.json file\n";
-    }else if(argc==2)
+    }else if(!badArgument.empty())
+    {
+        std::cout << "unknown argument " << badArgument << '\n';
+    }else
     {
         // get the parameter data
         std::ifstream f(argv[1]);
         nlohmann::json data = nlohmann::json::parse(f);
         auto jmap = data.get<std::unordered_map<std::string, float>>();
+        SA_settings settings = SA_settings::fromParameters(jmap);
+        SA_jsonSeed(data, settings);
 
-        // perform SA
-        SA<Schwefel::soln> SAinst(Schwefel::problemCtx, jmap);
-        auto start = std::chrono::high_resolution_clock::now();
-        SAinst.optimise();
-        auto finish = std::chrono::high_resolution_clock::now();
-        std::cout << "Optimisation took " << 
-                std::chrono::duration_cast<std::chrono::milliseconds>(finish-start).count() << "ms\n";
-        if(jmap["print results"])
+        // perform SA, "record mode" selects how the trajectory is kept:
+        // 0: not at all, 1: every "record interval"-th iteration in memory, 2: the last "record capacity"
+        // iterations, 3: streamed to trajectory.bin. By default the full trajectory is kept if "print results" is set
+        int recordMode = jmap.count("record mode") ? jmap["record mode"] : (jmap["print results"] ? 1 : 0);
+        int dimension;
+        try
         {
-            std::cout << "results saved to allSolutions.txt and acceptedSolutions.txt\n";
-            SAinst.printAllToFile("allSolutions.txt");
-            SAinst.printAcceptedToFile("acceptedSolutions.txt");
+            dimension = Schwefel::parseParameters(jmap).dimension;
+        }catch(const std::runtime_error& error)
+        {   // parameters the problem cannot run with
+            std::cout << error.what() << '\n';
+            return 1;
         }
-        std::cout << "number of function evaluations: " << Schwefel::num_of_evaluations << '\n';
-        std::cout << "final temperature: " << SAinst.getRuntimeInfo().temperature << '\n';
-        std::cout << "current solution: " << SAinst.getOptimisationResult().first.print() << '\n';
-        std::cout << "best solution: " << SAinst.getOptimisationResult().second.print() << '\n';
-    }else
-    {
-        std::cout << "too many arguments\n";
+        Schwefel::withDimension(dimension, [&](auto n)
+        {
+            constexpr int N = decltype(n)::value;
+            try
+            {
+                switch(recordMode)
+                {
+                    case 1: runWithRecorder<N, SA_decimatedRecorder<Schwefel::soln<N>>>(jmap, settings, compat, resumeFile); break;
+                    case 2: runWithRecorder<N, SA_ringRecorder<Schwefel::soln<N>>>(jmap, settings, compat, resumeFile); break;
+                    case 3: runWithRecorder<N, SA_streamRecorder<Schwefel::soln<N>>>(jmap, settings, compat, resumeFile); break;
+                    default: runWithRecorder<N, SA_nullRecorder<Schwefel::soln<N>>>(jmap, settings, compat, resumeFile); break;
+                }
+            }catch(const std::runtime_error& error)
+            {   // snapshots that cannot be written or read
+                std::cout << error.what() << '\n';
+            }
+        });
     }
 
     return 0;
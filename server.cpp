@@ -0,0 +1,337 @@
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "lib/engine.hpp"
+#include "lib/json.hpp"
+#include "lib/thread_pool.hpp"
+#include "third_party/nlohmann/json.hpp"
+#include "Example/SchwefelFunction/problem.hpp"
+
+// long lived solver: reads jobs as newline delimited json from stdin, or from every client of a unix socket, runs
+// them on a pool of warm worker threads and streams the events of each job back as newline delimited json.
+// usage: SA_server [--socket path] [--threads n] [--parameters parameters.json]
+// requests, one json object per line:
+//   {"id": "a", "parameters": {...}, "seed": 1, "progress interval": 0.5, "time budget": 2}   run a job, the
+//       parameters override the ones given with --parameters. Progress interval and time budget are in seconds
+//       and optional, the time budget and cancel also bound the initial temperature search
+//       Job ids belong to the client that sent them, the seed is read as a 64 bit integer
+//   {"cancel": "a"}      stop a job of this client, its result is sent with the best solution found so far
+//   {"shutdown": true}   finish the running jobs and exit, the requests after it are not run
+// events:
+//   {"id": "a", "event": "accepted"}
+//   {"id": "a", "event": "progress", "iteration": .., "temperature": .., "best f": .., "coordinate evaluations": ..}
+//   {"id": "a", "event": "result", "status": "finished" | "cancelled" | "time budget", "seed": .., "iterations": ..,
+//    "coordinate evaluations": .., "pre-search coordinate evaluations": .., "final temperature": .., "current f": .., "best f": .., "best x": [..],
+//    "runtime ms": ..}
+//   {"id": "a", "event": "error", "message": ".."}
+// Every worker thread keeps one engine per solution layout and resets it for the next job, so a job does not
+// allocate its solutions or the engine again.
+
+using json = nlohmann::json;
+
+// where the events of the jobs of a client go, lines are written whole. A socket is closed once the client has
+// gone and its last job has finished
+class connection
+{
+private:
+    int _fd;
+    std::mutex _mtx;
+
+public:
+    connection(int fd) : _fd(fd) {}
+
+    ~connection(){ if(_fd > 2) close(_fd); }
+
+    // makes a read of the client's requests return, so the thread serving it finishes
+    void stopReading(){ if(_fd > 2) shutdown(_fd, SHUT_RD); }
+
+    connection(const connection&) = delete;
+    connection& operator=(const connection&) = delete;
+
+    void send(const json& event)
+    {
+        std::string line = event.dump() + '\n';
+        std::lock_guard<std::mutex> lock(_mtx);
+        for(size_t done=0; done<line.size();)
+        {
+            ssize_t n = write(_fd, line.data() + done, line.size() - done);
+            if(n <= 0) return; // the client is gone, its events are dropped
+            done += n;
+        }
+    }
+};
+
+struct job
+{
+    std::string id;
+    std::unordered_map<std::string, float> parameters;
+    std::optional<uint64_t> seed; // random if not given
+    double progressInterval; // 0 for no progress events
+    double timeBudget; // 0 for none
+    std::shared_ptr<std::atomic<bool>> cancelled;
+    std::shared_ptr<connection> client;
+};
+
+class server
+{
+private:
+    std::unordered_map<std::string, float> _defaults;
+    std::optional<uint64_t> _defaultSeed;
+    ThreadPool _pool;
+    std::mutex _mtx;
+    // cancel flags by client and job id. A job keeps its client alive, so the pointer is not reused meanwhile
+    std::map<std::pair<connection*, std::string>, std::shared_ptr<std::atomic<bool>>> _running;
+    std::atomic<bool> _shutdown{false};
+
+    template <int N>
+    void runJob(job& j)
+    {
+        using engine_type = SA_engine<Schwefel::Problem<N>>;
+        thread_local std::unique_ptr<engine_type> engine;
+        auto start = std::chrono::steady_clock::now();
+        auto stopReason = [&]() -> std::string
+        {   // why the job has to stop, empty while it may go on
+            if(j.cancelled->load()) return "cancelled";
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if(j.timeBudget > 0 && elapsed >= j.timeBudget) return "time budget";
+            return "";
+        };
+        Schwefel::context<N> ctx = Schwefel::createContext<N>(j.parameters);
+        // the initial temperature search is bounded and cancelled too, it runs before the monitor is first called
+        ctx.continueSearch = [&]{ return stopReason().empty(); };
+        SA_settings settings = SA_settings::fromParameters(j.parameters);
+        settings.verbose = false;
+        settings.checkpointInterval = 0;
+        if(j.seed) settings.seed = *j.seed;
+        if(engine == nullptr) engine = std::make_unique<engine_type>(ctx, settings);
+        else engine->reset(ctx, settings);
+
+        double lastProgress = 0;
+        std::string status = "finished";
+        engine->optimise([&]
+        {
+            status = stopReason();
+            if(!status.empty()) return false;
+            status = "finished";
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if(j.progressInterval > 0 && elapsed - lastProgress >= j.progressInterval)
+            {
+                lastProgress = elapsed;
+                j.client->send({{"id", j.id}, {"event", "progress"}, {"iteration", engine->getNumIterations()},
+                                {"temperature", engine->getRuntimeInfo().temperature},
+                                {"best f", engine->getOptimisationResult().second.getEval()},
+                                {"coordinate evaluations", engine->getContext().num_of_evaluations}});
+            }
+            return true;
+        });
+        if(engine->getContext().searchStopped) status = j.cancelled->load() ? "cancelled" : "time budget";
+        engine->getContext().continueSearch = nullptr; // it refers to this job
+        double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::pair<Schwefel::soln<N>, Schwefel::soln<N>> result = engine->getOptimisationResult();
+        std::vector<float> bestX;
+        for(int i=0; i<result.second.size(); i++) bestX.push_back(result.second.getX(i));
+        j.client->send({{"id", j.id}, {"event", "result"}, {"status", status}, {"seed", engine->getSettings().seed},
+                        {"iterations", engine->getNumIterations()},
+                        {"coordinate evaluations", engine->getContext().num_of_evaluations},
+                        {"pre-search coordinate evaluations", engine->getContext().num_of_initial_evaluations},
+                        {"final temperature", engine->getRuntimeInfo().temperature},
+                        {"current f", result.first.getEval()}, {"best f", result.second.getEval()},
+                        {"best x", bestX}, {"runtime ms", elapsed}});
+    }
+
+    void run(job j)
+    {
+        try
+        {
+            Schwefel::withDimension(Schwefel::parseParameters(j.parameters).dimension, [&](auto n)
+            {
+                runJob<decltype(n)::value>(j);
+            });
+        }catch(const std::exception& error)
+        {
+            j.client->send({{"id", j.id}, {"event", "error"}, {"message", error.what()}});
+        }
+        std::lock_guard<std::mutex> lock(_mtx);
+        _running.erase({j.client.get(), j.id});
+    }
+
+    void submit(const json& request, std::shared_ptr<connection> client)
+    {
+        job j{request.value("id", std::string()), _defaults, _defaultSeed, request.value("progress interval", 0.0),
+              request.value("time budget", 0.0), std::make_shared<std::atomic<bool>>(false), client};
+        if(request.contains("parameters"))
+        {
+            for(auto& [key, value] : request["parameters"].items())
+            {
+                if(key == "seed") j.seed = value.get<uint64_t>();
+                else j.parameters[key] = value.get<float>();
+            }
+        }
+        if(request.contains("seed")) j.seed = request["seed"].get<uint64_t>();
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+            if(j.id.empty() || _running.count({client.get(), j.id}))
+            {
+                client->send({{"id", j.id}, {"event", "error"}, {"message", "jobs need an id that is not running"}});
+                return;
+            }
+            _running[{client.get(), j.id}] = j.cancelled;
+        }
+        client->send({{"id", j.id}, {"event", "accepted"}});
+        _pool.submit([this, j]{ run(j); });
+    }
+
+    void cancel(const std::string& id, std::shared_ptr<connection> client)
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        auto it = _running.find({client.get(), id});
+        if(it != _running.end()) it->second->store(true);
+        else client->send({{"id", id}, {"event", "error"}, {"message", "no such job"}});
+    }
+
+public:
+    server(const std::unordered_map<std::string, float>& defaults, std::optional<uint64_t> defaultSeed, int numThreads)
+        : _defaults(defaults), _defaultSeed(defaultSeed), _pool(numThreads)
+    {
+        _defaults.erase("seed");
+    }
+
+    bool isShutdown(){ return _shutdown; }
+
+    // reads requests from fd (0 for stdin, whose events go to client, stdout) until it is closed or a shutdown
+    // request
+    void serve(int fd, std::shared_ptr<connection> client)
+    {
+        std::string pending;
+        char buffer[4096];
+        while(!_shutdown)
+        {
+            ssize_t n = read(fd, buffer, sizeof(buffer));
+            if(n <= 0) break;
+            pending.append(buffer, n);
+            for(size_t end=pending.find('\n'); end!=std::string::npos; end=pending.find('\n'))
+            {
+                std::string line = pending.substr(0, end);
+                pending.erase(0, end + 1);
+                if(line.find_first_not_of(" \t\r") == std::string::npos) continue;
+                try
+                {
+                    json request = json::parse(line);
+                    if(request.contains("cancel")) cancel(request["cancel"].get<std::string>(), client);
+                    else if(request.value("shutdown", false)) _shutdown = true;
+                    else submit(request, client);
+                }catch(const std::exception& error)
+                {
+                    client->send({{"event", "error"}, {"message", error.what()}});
+                }
+                if(_shutdown) break; // the requests after a shutdown are not run, even if they were read with it
+            }
+        }
+    }
+
+    // waits for the jobs to finish
+    void drain(){ _pool.wait(); }
+};
+
+int main(int argc,
+         char *argv[]) {
+    std::string socketPath;
+    int numThreads = std::thread::hardware_concurrency();
+    std::unordered_map<std::string, float> defaults;
+    std::optional<uint64_t> defaultSeed;
+    for(int i=1; i<argc; i++)
+    {
+        std::string arg = argv[i];
+        if(arg == "--socket" && i + 1 < argc) socketPath = argv[++i];
+        else if(arg == "--threads" && i + 1 < argc) numThreads = std::stoi(argv[++i]);
+        else if(arg == "--parameters" && i + 1 < argc)
+        {
+            std::ifstream f(argv[++i]);
+            json data = json::parse(f);
+            defaults = data.get<std::unordered_map<std::string, float>>();
+            if(data.contains("seed")) defaultSeed = data["seed"].get<uint64_t>();
+        }else
+        {
+            std::cout << "usage: SA_server [--socket path] [--threads n] [--parameters parameters.json]\n";
+            return 0;
+        }
+    }
+    std::signal(SIGPIPE, SIG_IGN); // clients that go away only make writes fail
+
+    server s(defaults, defaultSeed, numThreads);
+    if(socketPath.empty())
+    {
+        s.serve(0, std::make_shared<connection>(1));
+        s.drain();
+        return 0;
+    }
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if(listener < 0 || socketPath.size() >= sizeof(address.sun_path))
+    {
+        std::cout << "cannot listen on " << socketPath << '\n';
+        return 1;
+    }
+    socketPath.copy(address.sun_path, socketPath.size());
+    unlink(socketPath.c_str());
+    if(bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 16) != 0)
+    {
+        std::cout << "cannot listen on " << socketPath << '\n';
+        return 1;
+    }
+    struct clientThread
+    {
+        std::shared_ptr<connection> client;
+        std::shared_ptr<std::atomic<bool>> done;
+        std::thread thread;
+    };
+    std::vector<clientThread> clients;
+    while(!s.isShutdown())
+    {   // the client thread that gets the shutdown request stops the listener
+        int fd = accept(listener, nullptr, nullptr);
+        if(fd < 0) break;
+        for(auto it=clients.begin(); it!=clients.end();)
+        {   // let go of the clients that have gone
+            if(!it->done->load())
+            {
+                ++it;
+                continue;
+            }
+            it->thread.join();
+            it = clients.erase(it);
+        }
+        std::shared_ptr<connection> client = std::make_shared<connection>(fd);
+        std::shared_ptr<std::atomic<bool>> done = std::make_shared<std::atomic<bool>>(false);
+        clients.push_back({client, done, std::thread([&s, fd, client, done, listener]
+        {
+            s.serve(fd, client);
+            if(s.isShutdown()) shutdown(listener, SHUT_RDWR);
+            done->store(true);
+        })});
+    }
+    // clients still connected stop sending jobs before the last ones are waited for, their events still go out
+    for(clientThread& c : clients) c.client->stopReading();
+    for(clientThread& c : clients) c.thread.join();
+    s.drain();
+    close(listener);
+    unlink(socketPath.c_str());
+    return 0;
+}
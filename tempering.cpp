@@ -0,0 +1,81 @@
+#include <iostream>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <chrono>
+#include "lib/core.hpp"
+#include "lib/json.hpp"
+#include "lib/tempering.hpp"
+#include "third_party/nlohmann/json.hpp"
+#include "Example/SchwefelFunction/problem.hpp"
+
+template <int N>
+void runTempering(std::unordered_map<std::string, float>& jmap, const SA_settings& settings)
+{
+    // perform parallel tempering through the function pointers of Schwefel::problemCtx
+    using Policy = ProblemCtxPolicy<Schwefel::soln<N>, Schwefel::context<N>>;
+    SA_tempering<Policy> PTinst(Policy::createContext(Schwefel::problemCtx<N>, jmap),
+                                settings,
+                                SA_temperingSettings::fromParameters(jmap));
+    auto start = std::chrono::high_resolution_clock::now();
+    PTinst.optimise();
+    auto finish = std::chrono::high_resolution_clock::now();
+    std::cout << "Optimisation took " <<
+            std::chrono::duration_cast<std::chrono::milliseconds>(finish-start).count() << "ms\n";
+
+    long numEvaluations = 0;
+    long numInitialEvaluations = 0;
+    for(int k=0; k<PTinst.getNumChains(); k++)
+    {
+        Schwefel::context<N>& ctx = PTinst.getChain(k).getContext().ctx;
+        numEvaluations += ctx.num_of_evaluations;
+        numInitialEvaluations += ctx.num_of_initial_evaluations;
+        std::cout << "chain " << k << " final temperature: " << PTinst.getChain(k).getRuntimeInfo().temperature << '\n';
+    }
+    std::cout << "seed: " << PTinst.getChain(0).getSettings().seed << '\n';
+    std::cout << "number of exchanges: " << PTinst.getNumExchanges() << '\n';
+    std::cout << "swap acceptance rates:";
+    for(float rate : PTinst.getSwapAcceptanceRates()) std::cout << ' ' << rate;
+    std::cout << '\n';
+    std::cout << "number of coordinate evaluations: " << numEvaluations << '\n';
+    std::cout << "number of pre-search coordinate evaluations: " << numInitialEvaluations << '\n';
+    std::cout << "current solution: " << PTinst.getOptimisationResult().first.print() << '\n';
+    std::cout << "best solution: " << PTinst.getOptimisationResult().second.print() << '\n';
+}
+
+int main(int argc,
+         char *argv[]) {
+    if(argc<=1)
+    {
+        std::cout << "missing paramters.json file\n";
+    }else if(argc==2)
+    {
+        // get the parameter data
+        std::ifstream f(argv[1]);
+        nlohmann::json data = nlohmann::json::parse(f);
+        auto jmap = data.get<std::unordered_map<std::string, float>>();
+        SA_settings settings = SA_settings::fromParameters(jmap);
+        SA_jsonSeed(data, settings);
+
+        // the dimension picks the soln<N> layout
+        int dimension;
+        try
+        {
+            dimension = Schwefel::parseParameters(jmap).dimension;
+        }catch(const std::runtime_error& error)
+        {   // parameters the problem cannot run with
+            std::cout << error.what() << '\n';
+            return 1;
+        }
+        Schwefel::withDimension(dimension, [&](auto n)
+        {
+            runTempering<decltype(n)::value>(jmap, settings);
+        });
+    }else
+    {
+        std::cout << "too many arguments\n";
+    }
+
+    return 0;
+}
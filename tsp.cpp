@@ -0,0 +1,88 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include "lib/engine.hpp"
+#include "lib/json.hpp"
+#include "third_party/nlohmann/json.hpp"
+#include "Example/TSP/problem.hpp"
+
+// anneals a random travelling salesman instance with in-place 2-opt moves, and counts the heap allocations made
+// during the annealing loop to show they do not grow with the iterations.
+// usage: SA_tsp <parameters.json> [cities]
+
+std::atomic<long> numAllocations{0};
+
+// the replacements are not inlined, where the compiler would see a pointer from malloc going to operator delete, or
+// one from operator new going to free (-Wmismatched-new-delete)
+__attribute__((noinline)) void* operator new(std::size_t size)
+{
+    numAllocations.fetch_add(1, std::memory_order_relaxed);
+    if(void* p = std::malloc(size > 0 ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void* p) noexcept { std::free(p); }
+
+void operator delete(void* p, std::size_t) noexcept { operator delete(p); }
+
+int main(int argc,
+         char *argv[]) {
+    if(argc<=1)
+    {
+        std::cout << "usage: SA_tsp <parameters.json> [cities]\n";
+        return 0;
+    }
+    std::ifstream f(argv[1]);
+    nlohmann::json data = nlohmann::json::parse(f);
+    auto jmap = data.get<std::unordered_map<std::string, float>>();
+    if(argc>2) jmap["cities"] = std::stoi(argv[2]);
+
+    SA_settings settings = SA_settings::fromParameters(jmap);
+    SA_jsonSeed(data, settings);
+    TSP::context ctx;
+    try
+    {
+        ctx = TSP::Problem::createContext(jmap);
+    }catch(const std::runtime_error& error)
+    {   // parameters the problem cannot run with
+        std::cout << error.what() << '\n';
+        return 1;
+    }
+    SA_engine<TSP::Problem> SAinst(ctx, settings);
+    long beforeInitialise = numAllocations.load();
+    auto start = std::chrono::steady_clock::now();
+    SAinst.initialise();
+    double initialLength = SAinst.getOptimisationResult().first.length();
+    long beforeLoop = numAllocations.load();
+    long allocationsAt[3] = {0, 0, 0}; // after a quarter, half and all of the iterations
+    long quarter = SAinst.getSettings().maxIterations / 4;
+    while(!SAinst.isFinished())
+    {
+        SAinst.step();
+        long it = SAinst.getNumIterations();
+        if(it == quarter) allocationsAt[0] = numAllocations.load() - beforeLoop;
+        if(it == 2 * quarter) allocationsAt[1] = numAllocations.load() - beforeLoop;
+    }
+    allocationsAt[2] = numAllocations.load() - beforeLoop;
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::pair<TSP::tour, TSP::tour> result = SAinst.getOptimisationResult();
+    std::cout << "seed: " << SAinst.getSettings().seed << '\n';
+    std::cout << "Optimisation took " << static_cast<long>(elapsed * 1000) << "ms\n";
+    std::cout << "iterations: " << SAinst.getNumIterations() << ", per second: " << SAinst.getNumIterations() / elapsed << '\n';
+    std::cout << "final temperature: " << SAinst.getRuntimeInfo().temperature << '\n';
+    std::cout << "allocations while initialising: " << beforeLoop - beforeInitialise << '\n';
+    std::cout << "allocations in the annealing loop after 1/4, 1/2 and all of the iterations (at most "
+              << quarter * 4 << "): " << allocationsAt[0] << ", " << allocationsAt[1] << ", " << allocationsAt[2] << '\n';
+    std::cout << "initial tour: " << initialLength << '\n';
+    std::cout << "current tour: " << result.first.print() << '\n';
+    std::cout << "best tour: " << result.second.print() << " (recomputed " << TSP::tourLength(SAinst.getContext(), result.second) << ")\n";
+
+    return 0;
+}
@@ -0,0 +1,172 @@
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "lib/core.hpp"
+#include "lib/json.hpp"
+#include "lib/racing.hpp"
+#include "third_party/nlohmann/json.hpp"
+#include "Example/SchwefelFunction/problem.hpp"
+
+// tunes the parameters of the parameter file by racing configurations taken at random from the ranges of the
+// tuning file (see SA_racing), running them in this process on a thread pool. Writes the configurations ranked,
+// with their success rate and expected time to target, to json.
+// usage: SA_tune <parameters.json> <tuning.json> <output.json>
+// the tuning file has the racing settings ("configurations", "rounds", "eta", "seeds", "threads", "seed" of the
+// configuration sampling and "run seed" of the runs), the target, "parameters" overriding those of the parameter
+// file (a larger "max eval" for instance) and
+//   "ranges": {"alpha": [0.0001, 0.01, "log"], "max same temperature chain": [10, 200, "int"], ..}
+// A run is successful once its best solution is within "l2 limit" (default 10, as in SA_ensemble) of the global
+// optimum or, with "target fraction" set, once its best f is within that fraction of the global minimum (0.95 for
+// within 5%, as in SA_bench)
+
+// the engine calls the monitor every 1024 steps, which is when runs are checked against the target
+const int targetCheckSteps = 1024;
+
+struct target
+{
+    float l2Limit;
+    float fraction; // 0 to use the l2 limit
+    float minimum; // f of the global optimum
+
+    template <int N>
+    bool reached(Schwefel::soln<N>& best, Schwefel::soln<N>& optimum)
+    {
+        return fraction > 0 ? best.getEval() <= fraction * minimum : Schwefel::l2(best, optimum) < l2Limit;
+    }
+};
+
+target runTarget; // set by main before the racing starts, only read by the runs
+
+template <int N>
+SA_raceRun runSchwefel(std::unordered_map<std::string, float>& parameters, uint64_t seed, float budgetFraction)
+{   // a run through the SA class with the parameters, its "max eval" and "max iterations" cut to the fraction of
+    // the budget. The best solution is checked against the target every targetCheckSteps steps, when the engine
+    // calls the monitor, so times to target are that coarse
+    parameters["verbose"] = 0;
+    parameters["max eval"] *= budgetFraction;
+    parameters["max iterations"] *= budgetFraction;
+    SA_settings settings = SA_settings::fromParameters(parameters);
+    settings.seed = seed;
+    SA<Schwefel::soln<N>, Schwefel::context<N>, SA_nullRecorder<Schwefel::soln<N>>> SAinst(Schwefel::problemCtx<N>, parameters, settings);
+    Schwefel::soln<N> optimum = Schwefel::globalOptimum<N>(Schwefel::parseParameters(parameters).dimension);
+    double timeToTarget = -1;
+    auto start = std::chrono::steady_clock::now();
+    SAinst.optimise([&]
+    {
+        if(timeToTarget >= 0) return true;
+        Schwefel::soln<N> best = SAinst.getOptimisationResult().second;
+        if(runTarget.reached(best, optimum))
+            timeToTarget = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return true;
+    });
+    double runtime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    Schwefel::soln<N> best = SAinst.getOptimisationResult().second;
+    if(timeToTarget < 0 && runTarget.reached(best, optimum)) timeToTarget = runtime;
+    return {.bestEval = best.getEval(), .runtime = runtime, .timeToTarget = timeToTarget};
+}
+
+nlohmann::json finiteOrNull(double value)
+{
+    return std::isfinite(value) ? nlohmann::json(value) : nlohmann::json();
+}
+
+int main(int argc,
+         char *argv[]) {
+    if(argc<4)
+    {
+        std::cout << "usage: SA_tune <parameters.json> <tuning.json> <output.json>\n";
+        return 0;
+    }
+    std::ifstream f(argv[1]);
+    auto jmap = nlohmann::json::parse(f).get<std::unordered_map<std::string, float>>();
+    std::ifstream g(argv[2]);
+    nlohmann::json tuning = nlohmann::json::parse(g);
+    std::unordered_map<std::string, float> racingParameters;
+    std::vector<SA_parameterRange> ranges;
+    for(auto& [key, value] : tuning.items())
+    {
+        if(value.is_number()) racingParameters[key] = value.get<float>();
+    }
+    for(auto& [name, range] : tuning["ranges"].items())
+    {
+        std::string scale = range.size() > 2 ? range[2].get<std::string>() : "";
+        ranges.push_back({name, range[0].get<float>(), range[1].get<float>(), scale == "log", scale == "int"});
+    }
+    if(tuning.contains("parameters"))
+    {
+        for(auto& [key, value] : tuning["parameters"].items()) jmap[key] = value.get<float>();
+    }
+    SA_racingSettings settings = SA_racingSettings::fromParameters(racingParameters);
+    if(tuning.contains("seed")) settings.seed = tuning["seed"].get<uint64_t>();
+    if(tuning.contains("run seed")) settings.runSeed = tuning["run seed"].get<uint64_t>();
+
+    int dimension;
+    try
+    {
+        dimension = Schwefel::parseParameters(jmap).dimension;
+    }catch(const std::runtime_error& error)
+    {   // parameters the problem cannot run with
+        std::cout << error.what() << '\n';
+        return 1;
+    }
+    SA_racing racing(settings);
+    std::vector<SA_candidate> ranked;
+    auto start = std::chrono::steady_clock::now();
+    Schwefel::withDimension(dimension, [&](auto n)
+    {
+        runTarget = {
+            .l2Limit = racingParameters.count("l2 limit") ? racingParameters["l2 limit"] : 10,
+            .fraction = racingParameters.count("target fraction") ? racingParameters["target fraction"] : 0,
+            .minimum = dimension * Schwefel::objectiveTerm(Schwefel::optimumXi)
+        };
+        ranked = racing.race(jmap, ranges, runSchwefel<decltype(n)::value>);
+    });
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    nlohmann::json out;
+    out["dimension"] = dimension;
+    out["threads"] = racing.numThreads();
+    out["total time s"] = elapsed;
+    if(runTarget.fraction > 0) out["target f"] = runTarget.fraction * runTarget.minimum;
+    else out["l2 limit"] = runTarget.l2Limit;
+    out["target checked every steps"] = targetCheckSteps; // times to target are rounded up to such a check
+    out["configurations"] = nlohmann::json::array();
+    for(SA_candidate& c : ranked)
+    {
+        nlohmann::json tuned;
+        for(SA_parameterRange& range : ranges) tuned[range.name] = c.parameters[range.name];
+        out["configurations"].push_back({
+            {"id", c.id},
+            {"parameters", tuned},
+            {"rounds", c.roundsRun},
+            {"dropped by test", c.droppedByTest},
+            {"budget fraction", c.budgetFraction},
+            {"runs", c.runs.size()},
+            {"mean best f", c.meanBest},
+            {"success rate", c.successRate},
+            {"expected time to target ms", finiteOrNull(c.expectedTimeToTarget)}
+        });
+    }
+    std::ofstream outfile(argv[3], std::ios::out|std::ios::trunc);
+    outfile << out.dump(4) << '\n';
+
+    std::cout << "raced " << ranked.size() << " configurations on " << racing.numThreads() << " threads in "
+              << elapsed << "s, the best ones:\n";
+    for(int i=0; i<ranked.size() && i<5; i++)
+    {
+        SA_candidate& c = ranked[i];
+        std::cout << (c.id == 0 ? "base" : "configuration " + std::to_string(c.id)) << ": mean best f " << c.meanBest
+                  << ", success rate " << c.successRate << " over " << c.runs.size() << " runs, expected time to target ";
+        if(std::isfinite(c.expectedTimeToTarget)) std::cout << c.expectedTimeToTarget << "ms\n";
+        else std::cout << "-\n";
+    }
+    std::cout << "(runs are checked against the target every " << targetCheckSteps << " steps, so the times to "
+              << "target are rounded up to the next check)\n";
+    std::cout << "results saved to " << argv[3] << '\n';
+    return 0;
+}